@@ -46,7 +46,7 @@ public:
 	QStringList locationsOfComputer( const QString& computer ) const;
 
 	Access checkAccess( const QString& accessingUser, const QString& accessingComputer,
-						const QStringList& connectedUsers );
+						const QStringList& connectedUsers, const QString& localUser = {} );
 
 	bool processAuthorizedGroups( const QString& accessingUser );
 
@@ -56,7 +56,7 @@ public:
 														 const QString& localComputer,
 														 const QStringList& connectedUsers );
 
-	bool isAccessToLocalComputerDenied() const;
+	bool isAccessToLocalComputerDenied( const QString& localUser = {} ) const;
 
 private:
 	bool isMemberOfUserGroup( const QString& user, const QString& groupName ) const;
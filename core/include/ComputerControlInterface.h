@@ -70,6 +70,8 @@ public:
 		return m_computer;
 	}
 
+	bool setComputer( const Computer& computer );
+
 	State state() const
 	{
 		return m_state;
@@ -129,9 +131,20 @@ public:
 
 	void setDesignatedModeFeature( Feature::Uid designatedModeFeature );
 
+	// set when the server pushes changes so that polling can be reduced to a heartbeat
+	void setUserInfoSubscribed( bool subscribed );
+	void setActiveFeaturesSubscribed( bool subscribed );
+
 	void sendFeatureMessage( const FeatureMessage& featureMessage, bool wake );
 	bool isMessageQueueEmpty();
 
+	/*!
+	 * \brief Encodes the message once per wire format in use and enqueues the shared frames on all
+	 * connections - returns without waiting for the messages being sent by the connection threads
+	 */
+	static void sendFeatureMessage( const FeatureMessage& featureMessage,
+									const QVector<Pointer>& computerControlInterfaces, bool wake );
+
 	void setUpdateMode( UpdateMode updateMode );
 	UpdateMode updateMode() const
 	{
@@ -147,11 +160,13 @@ private:
 	void updateState();
 	void updateUser();
 	void updateActiveFeatures();
+	void startUpdateTimers();
 
 	void handleFeatureMessage( const FeatureMessage& message );
 
 	static constexpr int ConnectionWatchdogTimeout = 10000;
 	static constexpr int UpdateIntervalDisabled = 5000;
+	static constexpr int SubscriptionHeartbeatInterval = 30000;
 
 	Computer m_computer;
 
@@ -171,6 +186,8 @@ private:
 	QTimer m_connectionWatchdogTimer;
 	QTimer m_userUpdateTimer;
 	QTimer m_activeFeaturesUpdateTimer;
+	bool m_userInfoSubscribed{false};
+	bool m_activeFeaturesSubscribed{false};
 
 	QStringList m_groups;
 
@@ -24,8 +24,12 @@
 
 #pragma once
 
+#include <QPointer>
+
 #include "SimpleFeatureProvider.h"
 
+class FeatureWorkerManager;
+
 class VEYON_CORE_EXPORT FeatureControl : public QObject, public SimpleFeatureProvider, public PluginInterface
 {
 	Q_OBJECT
@@ -35,6 +39,7 @@ public:
 	~FeatureControl() override = default;
 
 	bool queryActiveFeatures( const ComputerControlInterfaceList& computerControlInterfaces );
+	bool subscribeActiveFeatures( const ComputerControlInterfaceList& computerControlInterfaces );
 
 	Plugin::Uid uid() const override
 	{
@@ -82,16 +87,30 @@ private:
 	enum Commands
 	{
 		QueryActiveFeatures,
+		SubscribeActiveFeatures,
 	};
 
 	enum Arguments
 	{
 		ActiveFeatureList,
+		Subscribed,
+	};
+
+	struct Subscriber
+	{
+		VeyonServerInterface* server;
+		QPointer<FeatureWorkerManager> featureWorkerManager; // owned by server
+		MessageContext messageContext;
+		FeatureUidList activeFeatures;
 	};
 
+	void addSubscriber( VeyonServerInterface& server, const MessageContext& messageContext,
+						const FeatureUidList& activeFeatures );
+	void pushActiveFeatures();
+
 	const Feature m_featureControlFeature;
 	const FeatureList m_features;
 
-	FeatureUidList m_activeFeatures;
+	QList<Subscriber> m_subscribers;
 
 };
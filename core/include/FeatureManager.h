@@ -24,6 +24,7 @@
 
 #pragma once
 
+#include <QHash>
 #include <QObject>
 
 #include "Feature.h"
@@ -50,8 +51,12 @@ public:
 
 	const Feature& feature( Feature::Uid featureUid ) const;
 
+	const FeatureList& subFeatures( Feature::Uid parentFeatureUid ) const;
+
 	Plugin::Uid pluginUid( const Feature& feature ) const;
 
+	void updateFeatures();
+
 	void startFeature( VeyonMasterInterface& master,
 					   const Feature& feature,
 					   const ComputerControlInterfaceList& computerControlInterfaces );
@@ -68,10 +73,19 @@ public slots:
 	bool handleFeatureMessage( VeyonWorkerInterface& worker, const FeatureMessage& message );
 
 private:
+	FeatureProviderInterfaceList featureInterfaces( Feature::Uid featureUid ) const;
+
 	FeatureList m_features;
 	const FeatureList m_emptyFeatureList;
 	QObjectList m_pluginObjects;
 	FeatureProviderInterfaceList m_featurePluginInterfaces;
 	const Feature m_dummyFeature;
 
+	// lookup tables rebuilt by updateFeatures() whenever feature lists of plugins change
+	QHash<Plugin::Uid, FeatureProviderInterface *> m_pluginFeatureInterfaces;
+	QHash<Feature::Uid, Feature> m_featuresByUid;
+	QHash<Feature::Uid, Plugin::Uid> m_featurePluginUids;
+	QHash<Feature::Uid, FeatureProviderInterface *> m_featureInterfaces;
+	QHash<Feature::Uid, FeatureList> m_subFeatures;
+
 };
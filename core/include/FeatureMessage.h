@@ -44,6 +44,22 @@ public:
 		DefaultCommand = 0,
 		InvalidCommand = -1,
 		InitCommand = -2,
+		NegotiateWireFormatCommand = -3,
+		AssignFeatureCommand = -4,
+	};
+
+	// wire formats are identified by their schema version - legacy messages are
+	// encoded as VariantArrayMessage and understood by all peers
+	enum class WireFormat
+	{
+		Legacy = 0,
+		BinaryV1 = 1,
+		Latest = BinaryV1
+	};
+
+	enum class WireFormatArgument
+	{
+		SchemaVersion
 	};
 
 	explicit FeatureMessage( FeatureUid featureUid = {}, Command command = InvalidCommand ) :
@@ -99,13 +115,44 @@ public:
 		return m_arguments[QString::number( static_cast<int>( index ) )];
 	}
 
-	bool send( QIODevice* ioDevice ) const;
+	bool send( QIODevice* ioDevice, WireFormat wireFormat = WireFormat::Legacy ) const;
+
+	/*!
+	 * \brief Returns the complete frame as written by send() so it can be sent to multiple peers
+	 */
+	QByteArray encode( WireFormat wireFormat = WireFormat::Legacy ) const;
 
 	bool isReadyForReceive( QIODevice* ioDevice );
 
 	bool receive( QIODevice* ioDevice );
 
+	bool isWireFormatNegotiation() const
+	{
+		return m_command == NegotiateWireFormatCommand;
+	}
+
+	FeatureMessage& addWireFormatArgument( WireFormat wireFormat = WireFormat::Latest )
+	{
+		return addArgument( WireFormatArgument::SchemaVersion, static_cast<int>( wireFormat ) );
+	}
+
+	/*!
+	 * \brief Returns the newest wire format supported by both this and the peer which sent the given
+	 * negotiation message (also accepts init messages of workers)
+	 */
+	static WireFormat negotiatedWireFormat( const FeatureMessage& message );
+
 private:
+	using MessageSize = quint32;
+	using ArgumentKey = quint16;
+
+	static constexpr MessageSize BinaryFrameFlag = 0x80000000;
+	static constexpr MessageSize MaxMessageSize = 1024*1024*32;
+
+	QByteArray encodeBinary() const;
+	bool decodeBinary( const QByteArray& data );
+	bool decodeLegacy( const QByteArray& data );
+
 	FeatureUid m_featureUid;
 	Command m_command;
 	Arguments m_arguments;
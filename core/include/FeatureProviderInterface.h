@@ -97,10 +97,7 @@ protected:
 							 const ComputerControlInterfaceList& computerControlInterfaces,
 							 bool wake = true )
 	{
-		for( const auto& controlInterface : computerControlInterfaces )
-		{
-			controlInterface->sendFeatureMessage( message, wake );
-		}
+		ComputerControlInterface::sendFeatureMessage( message, computerControlInterfaces, wake );
 
 		return true;
 	}
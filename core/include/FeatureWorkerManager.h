@@ -27,8 +27,9 @@
 #include <QMutex>
 #include <QPointer>
 #include <QProcess>
-#include <QTcpServer>
-#include <QTcpSocket>
+#include <QLocalServer>
+#include <QLocalSocket>
+#include <QTimer>
 
 #include "FeatureMessage.h"
 
@@ -45,6 +46,12 @@ public:
 		WorkerProcessModeCount
 	} ;
 
+	// arguments of the init message sent by pooled workers not assigned to a feature yet
+	enum class PooledWorkerArgument
+	{
+		ProcessId = static_cast<int>( FeatureMessage::WireFormatArgument::SchemaVersion ) + 1
+	};
+
 	FeatureWorkerManager( VeyonServerInterface& server, FeatureManager& featureManager, QObject* parent = nullptr );
 	~FeatureWorkerManager() override;
 
@@ -56,26 +63,60 @@ public:
 	bool isWorkerRunning( const Feature& feature );
 	FeatureUidList runningWorkers();
 
+	// name of the local socket (AF_UNIX socket or named pipe) workers connect to
+	static QString serverName( int sessionId );
+
+	static QString pooledWorkerArgument()
+	{
+		return QStringLiteral("--pooled");
+	}
+
+signals:
+	void runningWorkersChanged();
+
 private:
 	void acceptConnection();
-	void processConnection( QTcpSocket* socket );
-	void closeConnection( QTcpSocket* socket );
+	void processConnection( QLocalSocket* socket );
+	void processMessage( QLocalSocket* socket, const FeatureMessage& message );
+	void closeConnection( QLocalSocket* socket );
 
-	void sendPendingMessages();
+	Q_INVOKABLE void sendPendingMessages();
+
+	void fillWorkerPool();
+	void registerPooledWorker( QLocalSocket* socket, const FeatureMessage& message );
 
 	static constexpr auto UnmanagedSessionProcessRetryInterval = 5000;
+	static constexpr auto WorkerPoolStartDelay = 5000;
+	static constexpr auto WorkerPoolRefillDelay = 1000;
+	static constexpr auto PooledWorkerStopTimeout = 3000;
+	static constexpr auto WorkerPoolRetryInterval = 10000;
 
 	VeyonServerInterface& m_server;
 	FeatureManager& m_featureManager;
-	QTcpServer m_tcpServer;
+	QLocalServer m_localServer;
 
 	struct Worker
 	{
-		QPointer<QTcpSocket> socket;
+		QPointer<QLocalSocket> socket;
 		QPointer<QProcess> process;
 		QList<FeatureMessage> pendingMessages;
+		FeatureMessage::WireFormat wireFormat{FeatureMessage::WireFormat::Legacy};
 	};
 
+	void sendPendingMessages( Worker& worker );
+	bool assignPooledWorker( const Feature& feature, Worker& worker );
+	void stopPooledWorkers();
+
+	struct PooledWorker
+	{
+		QPointer<QProcess> process;
+		QPointer<QLocalSocket> socket;
+		FeatureMessage::WireFormat wireFormat{FeatureMessage::WireFormat::Legacy};
+	};
+
+	QList<PooledWorker> m_workerPool;
+	QTimer m_workerPoolRetryTimer;
+
 	using WorkerMap = QMap<Feature::Uid, Worker>;
 	WorkerMap m_workers;
 
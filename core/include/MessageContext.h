@@ -26,7 +26,7 @@
 
 #include <QPointer>
 
-#include "VeyonCore.h"
+#include "FeatureMessage.h"
 
 class QIODevice;
 
@@ -35,8 +35,10 @@ class VEYON_CORE_EXPORT MessageContext
 public:
 	using IODevice = QPointer<QIODevice>;
 
-	explicit MessageContext( QIODevice* ioDevice ) :
-		m_ioDevice( ioDevice )
+	explicit MessageContext( QIODevice* ioDevice,
+							 FeatureMessage::WireFormat wireFormat = FeatureMessage::WireFormat::Legacy ) :
+		m_ioDevice( ioDevice ),
+		m_wireFormat( wireFormat )
 	{
 	}
 
@@ -47,7 +49,13 @@ public:
 		return m_ioDevice;
 	}
 
+	FeatureMessage::WireFormat wireFormat() const
+	{
+		return m_wireFormat;
+	}
+
 private:
 	IODevice m_ioDevice;
+	FeatureMessage::WireFormat m_wireFormat;
 
 } ;
@@ -24,8 +24,12 @@
 
 #pragma once
 
+#include <QPointer>
+
 #include "SimpleFeatureProvider.h"
 
+class FeatureWorkerManager;
+
 class MonitoringMode : public QObject, SimpleFeatureProvider, PluginInterface
 {
 	Q_OBJECT
@@ -74,6 +78,7 @@ public:
 	}
 
 	bool queryLoggedOnUserInfo( const ComputerControlInterfaceList& computerControlInterfaces );
+	bool subscribeLoggedOnUserInfo( const ComputerControlInterfaceList& computerControlInterfaces );
 
 	bool handleFeatureMessage( VeyonMasterInterface& master, const FeatureMessage& message,
 							   ComputerControlInterface::Pointer computerControlInterface ) override;
@@ -84,20 +89,43 @@ public:
 
 
 private:
-	void queryUserInformation();
+	void queryUserInformation( const QString& sessionUser );
+	Q_INVOKABLE void pushUserInformation( const QString& sessionUser );
 
 	const Feature m_monitoringModeFeature;
 	const Feature m_queryLoggedOnUserInfoFeature;
 	const FeatureList m_features;
 
+	enum Commands
+	{
+		QueryUserInfo = FeatureMessage::DefaultCommand,
+		SubscribeUserInfo,
+	};
+
 	enum Arguments
 	{
 		UserLoginName,
 		UserFullName,
+		Subscribed,
+	};
+
+	struct UserInfo
+	{
+		QString loginName;
+		QString fullName;
+	};
+
+	// clients waiting for user information which is not available yet
+	struct Subscriber
+	{
+		VeyonServerInterface* server;
+		QPointer<FeatureWorkerManager> featureWorkerManager; // owned by server
+		MessageContext messageContext;
 	};
 
 	QReadWriteLock m_userDataLock;
-	QString m_userLoginName;
-	QString m_userFullName;
+	QMap<QString, UserInfo> m_userInfo;
+
+	QList<Subscriber> m_subscribers;
 
 };
@@ -73,6 +73,7 @@ protected:
 private:
 	QTimer* m_updateTimer;
 	QHash<NetworkObject::ModelId, NetworkObjectList> m_objects;
+	QHash<NetworkObject::ModelId, NetworkObject::ModelId> m_parentIds;
 	NetworkObject m_invalidObject;
 	NetworkObject m_rootObject;
 	NetworkObjectList m_defaultObjectList;
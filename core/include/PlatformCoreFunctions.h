@@ -25,6 +25,7 @@
 #pragma once
 
 #include <QFile>
+#include <QProcessEnvironment>
 
 #include "Logger.h"
 #include "PlatformPluginInterface.h"
@@ -59,7 +60,8 @@ public:
 	virtual bool runProgramAsUser( const QString& program,
 								   const QStringList& parameters,
 								   const QString& username,
-								   const QString& desktop ) = 0;
+								   const QString& desktop,
+								   const QProcessEnvironment& environment = {} ) = 0;
 
 	virtual QString genericUrlHandler() const = 0;
 
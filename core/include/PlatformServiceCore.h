@@ -24,6 +24,8 @@
 
 #pragma once
 
+#include <QProcessEnvironment>
+
 #include "VeyonCore.h"
 
 // clazy:excludeall=copyable-polymorphic
@@ -36,8 +38,24 @@ public:
 	constexpr static SessionId SessionIdInvalid = -1;
 	constexpr static SessionId SessionIdMax = 99;
 
+	enum class SharedServerCommand {
+		InvalidCommand,
+		OpenSession,
+		CloseSession
+	};
+
 	PlatformServiceCore();
 
+	static QString sharedServerArgument()
+	{
+		return QStringLiteral("--shared-server");
+	}
+
+	static QByteArray encodeSharedServerCommand( SharedServerCommand command, SessionId sessionId,
+												 const QProcessEnvironment& sessionEnvironment = {} );
+	static SharedServerCommand decodeSharedServerCommand( const QByteArray& data, SessionId& sessionId,
+														  QProcessEnvironment& sessionEnvironment );
+
 	SessionId openSession( const QVariant& sessionData );
 	void closeSession( SessionId sessionId );
 
@@ -49,8 +67,14 @@ public:
 		return m_multiSession;
 	}
 
+	bool sharedServer() const
+	{
+		return m_sharedServer;
+	}
+
 private:
 	QMap<SessionId, QVariant> m_sessions;
 	bool m_multiSession;
+	bool m_sharedServer;
 
 };
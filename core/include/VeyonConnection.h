@@ -26,11 +26,10 @@
 
 #include <QPointer>
 
+#include "FeatureMessage.h"
 #include "VncConnection.h"
 
 
-class FeatureMessage;
-
 class VEYON_CORE_EXPORT VeyonConnection : public QObject
 {
 	Q_OBJECT
@@ -64,6 +63,12 @@ public:
 	}
 
 	void sendFeatureMessage( const FeatureMessage& featureMessage, bool wake );
+	void sendFeatureMessage( const FeatureMessage& featureMessage, const QByteArray& frame, bool wake );
+
+	FeatureMessage::WireFormat featureMessageWireFormat() const
+	{
+		return m_featureMessageWireFormat;
+	}
 
 	bool handleServerMessage( rfbClient* client, uint8_t msg );
 
@@ -77,12 +82,16 @@ private:
 	void registerConnection();
 	void unregisterConnection();
 
+	void negotiateFeatureMessageWireFormat();
+
 	// authentication
 	static int8_t handleSecTypeVeyon( rfbClient* client, uint32_t authScheme );
 	static void hookPrepareAuthentication( rfbClient* client );
 
 	QPointer<VncConnection> m_vncConnection;
 
+	std::atomic<FeatureMessage::WireFormat> m_featureMessageWireFormat;
+
 	QString m_user;
 	QString m_userHomeDir;
 
@@ -24,6 +24,10 @@
 
 #pragma once
 
+#include <QProcessEnvironment>
+
+#include "CryptoCore.h"
+
 class BuiltinFeatures;
 class FeatureMessage;
 class FeatureWorkerManager;
@@ -32,8 +36,23 @@ class MessageContext;
 class VeyonServerInterface
 {
 public:
+	using Password = CryptoCore::PlaintextPassword;
+
 	virtual ~VeyonServerInterface() = default;
 
+	virtual int sessionId() const = 0;
+
+	/*!
+	 * \brief Returns the name of the user logged on in the served session or an empty string
+	 * if the session is the one of the server process itself
+	 */
+	virtual QString sessionUser() const = 0;
+
+	virtual QProcessEnvironment sessionEnvironment() const = 0;
+
+	virtual int vncServerPort() const = 0;
+	virtual Password vncServerPassword() const = 0;
+
 	virtual FeatureWorkerManager& featureWorkerManager() = 0;
 	virtual bool sendFeatureMessageReply( const MessageContext& context, const FeatureMessage& reply ) = 0;
 
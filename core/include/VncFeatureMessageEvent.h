@@ -32,11 +32,17 @@
 class VncFeatureMessageEvent : public VncEvent
 {
 public:
-	explicit VncFeatureMessageEvent( const FeatureMessage& featureMessage );
+	explicit VncFeatureMessageEvent( const FeatureMessage& featureMessage,
+									 FeatureMessage::WireFormat wireFormat = FeatureMessage::WireFormat::Legacy );
+
+	// sends an already encoded frame which may be shared with other events
+	VncFeatureMessageEvent( const FeatureMessage& featureMessage, const QByteArray& frame );
 
 	void fire( rfbClient* client ) override;
 
 private:
 	FeatureMessage m_featureMessage;
+	FeatureMessage::WireFormat m_wireFormat;
+	const QByteArray m_frame;
 
 } ;
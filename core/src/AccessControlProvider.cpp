@@ -120,7 +120,8 @@ QStringList AccessControlProvider::locationsOfComputer( const QString& computer
 
 AccessControlProvider::Access AccessControlProvider::checkAccess( const QString& accessingUser,
 																  const QString& accessingComputer,
-																  const QStringList& connectedUsers )
+																  const QStringList& connectedUsers,
+																  const QString& localUser )
 {
 	if( VeyonCore::config().isAccessRestrictedToUserGroups() )
 	{
@@ -133,7 +134,7 @@ AccessControlProvider::Access AccessControlProvider::checkAccess( const QString&
 	{
 		auto action = processAccessControlRules( accessingUser,
 												 accessingComputer,
-												 VeyonCore::platform().userFunctions().currentUser(),
+												 localUser.isEmpty() ? VeyonCore::platform().userFunctions().currentUser() : localUser,
 												 HostAddress::localFQDN(),
 												 connectedUsers );
 		switch( action )
@@ -205,7 +206,7 @@ AccessControlRule::Action AccessControlProvider::processAccessControlRules( cons
 /*!
  * \brief Returns whether any incoming access requests would be denied due to a deny rule matching the local state (e.g. teacher logged on)
  */
-bool AccessControlProvider::isAccessToLocalComputerDenied() const
+bool AccessControlProvider::isAccessToLocalComputerDenied( const QString& localUser ) const
 {
 	if( VeyonCore::config().isAccessControlRulesProcessingEnabled() == false )
 	{
@@ -215,7 +216,8 @@ bool AccessControlProvider::isAccessToLocalComputerDenied() const
 	for( const auto& rule : qAsConst( m_accessControlRules ) )
 	{
 		if( matchConditions( rule, {}, {},
-							 VeyonCore::platform().userFunctions().currentUser(), HostAddress::localFQDN(), {} ) )
+							 localUser.isEmpty() ? VeyonCore::platform().userFunctions().currentUser() : localUser,
+							 HostAddress::localFQDN(), {} ) )
 		{
 			switch( rule.action() )
 			{
@@ -22,6 +22,8 @@
  *
  */
 
+#include <array>
+
 #include "BuiltinFeatures.h"
 #include "ComputerControlInterface.h"
 #include "Computer.h"
@@ -128,11 +130,29 @@ void ComputerControlInterface::stop()
 	m_userUpdateTimer.stop();
 	m_connectionWatchdogTimer.stop();
 
+	m_userInfoSubscribed = false;
+	m_activeFeaturesSubscribed = false;
+
 	m_state = State::Disconnected;
 }
 
 
 
+bool ComputerControlInterface::setComputer( const Computer& computer )
+{
+	// the existing connection can only be kept for the same host
+	if( computer.hostAddress() != m_computer.hostAddress() )
+	{
+		return false;
+	}
+
+	m_computer = computer;
+
+	return true;
+}
+
+
+
 void ComputerControlInterface::setScaledScreenSize( QSize scaledScreenSize )
 {
 	m_scaledScreenSize = scaledScreenSize;
@@ -218,6 +238,30 @@ void ComputerControlInterface::setDesignatedModeFeature( Feature::Uid designated
 
 
 
+void ComputerControlInterface::setUserInfoSubscribed( bool subscribed )
+{
+	if( subscribed != m_userInfoSubscribed )
+	{
+		m_userInfoSubscribed = subscribed;
+
+		startUpdateTimers();
+	}
+}
+
+
+
+void ComputerControlInterface::setActiveFeaturesSubscribed( bool subscribed )
+{
+	if( subscribed != m_activeFeaturesSubscribed )
+	{
+		m_activeFeaturesSubscribed = subscribed;
+
+		startUpdateTimers();
+	}
+}
+
+
+
 void ComputerControlInterface::sendFeatureMessage( const FeatureMessage& featureMessage, bool wake )
 {
 	if( m_connection && m_connection->isConnected() )
@@ -228,6 +272,30 @@ void ComputerControlInterface::sendFeatureMessage( const FeatureMessage& feature
 
 
 
+void ComputerControlInterface::sendFeatureMessage( const FeatureMessage& featureMessage,
+												   const QVector<Pointer>& computerControlInterfaces, bool wake )
+{
+	std::array<QByteArray, static_cast<size_t>( FeatureMessage::WireFormat::Latest ) + 1> frames;
+
+	for( const auto& computerControlInterface : computerControlInterfaces )
+	{
+		const auto connection = computerControlInterface->m_connection;
+		if( connection && connection->isConnected() )
+		{
+			const auto wireFormat = connection->featureMessageWireFormat();
+			auto& frame = frames[static_cast<size_t>( wireFormat )];
+			if( frame.isEmpty() )
+			{
+				frame = featureMessage.encode( wireFormat );
+			}
+
+			connection->sendFeatureMessage( featureMessage, frame, wake );
+		}
+	}
+}
+
+
+
 bool ComputerControlInterface::isMessageQueueEmpty()
 {
 	if( m_vncConnection && m_vncConnection->isConnected() )
@@ -243,32 +311,23 @@ void ComputerControlInterface::setUpdateMode( UpdateMode updateMode )
 {
 	m_updateMode = updateMode;
 
-	const auto computerMonitoringUpdateInterval = VeyonCore::config().computerMonitoringUpdateInterval();
-
-	switch( updateMode )
+	if( m_vncConnection )
 	{
-	case UpdateMode::Disabled:
-		if( m_vncConnection )
+		switch( updateMode )
 		{
+		case UpdateMode::Disabled:
 			m_vncConnection->setFramebufferUpdateInterval( UpdateIntervalDisabled );
+			break;
+		case UpdateMode::Monitoring:
+			m_vncConnection->setFramebufferUpdateInterval( VeyonCore::config().computerMonitoringUpdateInterval() );
+			break;
+		case UpdateMode::Live:
+			m_vncConnection->setFramebufferUpdateInterval( -1 );
+			break;
 		}
-
-		m_userUpdateTimer.stop();
-		m_activeFeaturesUpdateTimer.start( UpdateIntervalDisabled );
-		break;
-
-	case UpdateMode::Monitoring:
-	case UpdateMode::Live:
-		if( m_vncConnection )
-		{
-			m_vncConnection->setFramebufferUpdateInterval( updateMode == UpdateMode::Monitoring ?
-															   computerMonitoringUpdateInterval : -1 );
-		}
-
-		m_userUpdateTimer.start( computerMonitoringUpdateInterval );
-		m_activeFeaturesUpdateTimer.start( computerMonitoringUpdateInterval );
-		break;
 	}
+
+	startUpdateTimers();
 }
 
 
@@ -332,13 +391,14 @@ void ComputerControlInterface::updateUser()
 	{
 		if( userLoginName().isEmpty() )
 		{
-			VeyonCore::builtinFeatures().monitoringMode().queryLoggedOnUserInfo( { weakPointer() } );
+			VeyonCore::builtinFeatures().monitoringMode().subscribeLoggedOnUserInfo( { weakPointer() } );
 		}
 	}
 	else
 	{
 		setUserLoginName( {} );
 		setUserFullName( {} );
+		setUserInfoSubscribed( false );
 	}
 }
 
@@ -348,16 +408,37 @@ void ComputerControlInterface::updateActiveFeatures()
 {
 	if( m_vncConnection && m_connection && state() == State::Connected )
 	{
-		VeyonCore::builtinFeatures().featureControl().queryActiveFeatures( { weakPointer() } );
+		// subscriptions are idempotent on the server so this also serves as heartbeat
+		VeyonCore::builtinFeatures().featureControl().subscribeActiveFeatures( { weakPointer() } );
 	}
 	else
 	{
 		setActiveFeatures( {} );
+		setActiveFeaturesSubscribed( false );
 	}
 }
 
 
 
+void ComputerControlInterface::startUpdateTimers()
+{
+	const auto pollingInterval = m_updateMode == UpdateMode::Disabled ?
+									 UpdateIntervalDisabled : VeyonCore::config().computerMonitoringUpdateInterval();
+
+	if( m_updateMode == UpdateMode::Disabled )
+	{
+		m_userUpdateTimer.stop();
+	}
+	else
+	{
+		m_userUpdateTimer.start( m_userInfoSubscribed ? SubscriptionHeartbeatInterval : pollingInterval );
+	}
+
+	m_activeFeaturesUpdateTimer.start( m_activeFeaturesSubscribed ? SubscriptionHeartbeatInterval : pollingInterval );
+}
+
+
+
 void ComputerControlInterface::handleFeatureMessage( const FeatureMessage& message )
 {
 	emit featureMessageReceived( message, weakPointer() );
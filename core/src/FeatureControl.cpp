@@ -49,6 +49,14 @@ bool FeatureControl::queryActiveFeatures( const ComputerControlInterfaceList& co
 
 
 
+bool FeatureControl::subscribeActiveFeatures( const ComputerControlInterfaceList& computerControlInterfaces )
+{
+	return sendFeatureMessage( FeatureMessage( m_featureControlFeature.uid(), SubscribeActiveFeatures ),
+							   computerControlInterfaces, false );
+}
+
+
+
 bool FeatureControl::handleFeatureMessage( VeyonMasterInterface& master, const FeatureMessage& message,
 										   ComputerControlInterface::Pointer computerControlInterface )
 {
@@ -58,6 +66,12 @@ bool FeatureControl::handleFeatureMessage( VeyonMasterInterface& master, const F
 	{
 		computerControlInterface->setActiveFeatures( message.argument( ActiveFeatureList ).toStringList() );
 
+		if( message.command() == SubscribeActiveFeatures )
+		{
+			// servers without subscription support reply without this argument
+			computerControlInterface->setActiveFeaturesSubscribed( message.argument( Subscribed ).toBool() );
+		}
+
 		return true;
 	}
 
@@ -72,11 +86,76 @@ bool FeatureControl::handleFeatureMessage( VeyonServerInterface& server,
 {
 	if( m_featureControlFeature.uid() == message.featureUid() )
 	{
+		const auto activeFeatures = server.featureWorkerManager().runningWorkers();
+
 		FeatureMessage reply( message.featureUid(), message.command() );
-		reply.addArgument( ActiveFeatureList, server.featureWorkerManager().runningWorkers() );
+		reply.addArgument( ActiveFeatureList, activeFeatures );
+
+		if( message.command() == SubscribeActiveFeatures )
+		{
+			addSubscriber( server, messageContext, activeFeatures );
+			reply.addArgument( Subscribed, true );
+		}
 
 		return server.sendFeatureMessageReply( messageContext, reply );
 	}
 
 	return false;
 }
+
+
+
+void FeatureControl::addSubscriber( VeyonServerInterface& server, const MessageContext& messageContext,
+									const FeatureUidList& activeFeatures )
+{
+	for( auto it = m_subscribers.begin(); it != m_subscribers.end(); )
+	{
+		if( it->messageContext.ioDevice() == nullptr || it->featureWorkerManager.isNull() )
+		{
+			it = m_subscribers.erase( it );
+		}
+		else if( it->messageContext.ioDevice() == messageContext.ioDevice() )
+		{
+			// already subscribed (heartbeat)
+			it->messageContext = messageContext;
+			it->activeFeatures = activeFeatures;
+			return;
+		}
+		else
+		{
+			++it;
+		}
+	}
+
+	connect( &server.featureWorkerManager(), &FeatureWorkerManager::runningWorkersChanged,
+			 this, &FeatureControl::pushActiveFeatures, Qt::UniqueConnection );
+
+	m_subscribers.append( { &server, &server.featureWorkerManager(), messageContext, activeFeatures } );
+}
+
+
+
+void FeatureControl::pushActiveFeatures()
+{
+	for( auto it = m_subscribers.begin(); it != m_subscribers.end(); )
+	{
+		if( it->messageContext.ioDevice() == nullptr || it->featureWorkerManager.isNull() )
+		{
+			it = m_subscribers.erase( it );
+			continue;
+		}
+
+		const auto activeFeatures = it->featureWorkerManager->runningWorkers();
+		if( activeFeatures != it->activeFeatures )
+		{
+			it->activeFeatures = activeFeatures;
+
+			it->server->sendFeatureMessageReply( it->messageContext,
+												 FeatureMessage( m_featureControlFeature.uid(), SubscribeActiveFeatures )
+													 .addArgument( ActiveFeatureList, activeFeatures )
+													 .addArgument( Subscribed, true ) );
+		}
+
+		++it;
+	}
+}
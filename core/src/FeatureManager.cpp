@@ -52,25 +52,28 @@ FeatureManager::FeatureManager( QObject* parent ) :
 			m_pluginObjects += pluginObject;
 			m_featurePluginInterfaces += featurePluginInterface;
 
-			m_features += featurePluginInterface->featureList();
+			const auto pluginInterface = qobject_cast<PluginInterface *>( pluginObject );
+			if( pluginInterface && m_pluginFeatureInterfaces.contains( pluginInterface->uid() ) == false )
+			{
+				m_pluginFeatureInterfaces[pluginInterface->uid()] = featurePluginInterface;
+			}
 		}
 	}
 
+	updateFeatures();
+
+	// plugins update dynamic features (e.g. predefined programs) once the application has been loaded
+	connect( VeyonCore::instance(), &VeyonCore::applicationLoaded, this, &FeatureManager::updateFeatures );
 }
 
 
 
 const FeatureList& FeatureManager::features( Plugin::Uid pluginUid ) const
 {
-	for( auto pluginObject : m_pluginObjects )
+	const auto featurePluginInterface = m_pluginFeatureInterfaces.value( pluginUid );
+	if( featurePluginInterface )
 	{
-		auto pluginInterface = qobject_cast<PluginInterface *>( pluginObject );
-		auto featurePluginInterface = qobject_cast<FeatureProviderInterface *>( pluginObject );
-
-		if( pluginInterface && featurePluginInterface && pluginInterface->uid() == pluginUid )
-		{
-			return featurePluginInterface->featureList();
-		}
+		return featurePluginInterface->featureList();
 	}
 
 	return m_emptyFeatureList;
@@ -80,6 +83,13 @@ const FeatureList& FeatureManager::features( Plugin::Uid pluginUid ) const
 
 const Feature& FeatureManager::feature( Feature::Uid featureUid ) const
 {
+	const auto it = m_featuresByUid.constFind( featureUid );
+	if( it != m_featuresByUid.constEnd() )
+	{
+		return *it;
+	}
+
+	// feature might have been added by a plugin with dynamic features since the last update
 	for( const auto& featureInterface : m_featurePluginInterfaces )
 	{
 		for( const auto& feature : featureInterface->featureList() )
@@ -96,8 +106,27 @@ const Feature& FeatureManager::feature( Feature::Uid featureUid ) const
 
 
 
+const FeatureList& FeatureManager::subFeatures( Feature::Uid parentFeatureUid ) const
+{
+	const auto it = m_subFeatures.constFind( parentFeatureUid );
+	if( it != m_subFeatures.constEnd() )
+	{
+		return *it;
+	}
+
+	return m_emptyFeatureList;
+}
+
+
+
 Plugin::Uid FeatureManager::pluginUid( const Feature& feature ) const
 {
+	const auto it = m_featurePluginUids.constFind( feature.uid() );
+	if( it != m_featurePluginUids.constEnd() )
+	{
+		return *it;
+	}
+
 	for( auto pluginObject : m_pluginObjects )
 	{
 		auto pluginInterface = qobject_cast<PluginInterface *>( pluginObject );
@@ -115,6 +144,42 @@ Plugin::Uid FeatureManager::pluginUid( const Feature& feature ) const
 
 
 
+void FeatureManager::updateFeatures()
+{
+	m_features.clear();
+	m_featuresByUid.clear();
+	m_featurePluginUids.clear();
+	m_featureInterfaces.clear();
+	m_subFeatures.clear();
+
+	for( const auto& pluginObject : qAsConst( m_pluginObjects ) )
+	{
+		const auto featurePluginInterface = qobject_cast<FeatureProviderInterface *>( pluginObject );
+		const auto pluginInterface = qobject_cast<PluginInterface *>( pluginObject );
+		const auto pluginUid = pluginInterface ? pluginInterface->uid() : Plugin::Uid();
+
+		// copy the feature list as plugins may replace it at any time
+		const auto features = featurePluginInterface->featureList();
+
+		m_features += features;
+
+		for( const auto& feature : features )
+		{
+			// first plugin providing a feature wins as with the former linear lookups
+			if( m_featuresByUid.contains( feature.uid() ) == false )
+			{
+				m_featuresByUid[feature.uid()] = feature;
+				m_featurePluginUids[feature.uid()] = pluginUid;
+				m_featureInterfaces[feature.uid()] = featurePluginInterface;
+			}
+
+			m_subFeatures[feature.parentUid()] += feature;
+		}
+	}
+}
+
+
+
 void FeatureManager::startFeature( VeyonMasterInterface& master,
 								   const Feature& feature,
 								   const ComputerControlInterfaceList& computerControlInterfaces )
@@ -168,7 +233,7 @@ bool FeatureManager::handleFeatureMessage( VeyonMasterInterface& master, const F
 
 	bool handled = false;
 
-	for( const auto& featureInterface : qAsConst( m_featurePluginInterfaces ) )
+	for( const auto& featureInterface : featureInterfaces( message.featureUid() ) )
 	{
 		if( featureInterface->handleFeatureMessage( master, message, computerControlInterface ) )
 		{
@@ -197,7 +262,7 @@ bool FeatureManager::handleFeatureMessage( VeyonServerInterface& server,
 
 	bool handled = false;
 
-	for( const auto& featureInterface : qAsConst( m_featurePluginInterfaces ) )
+	for( const auto& featureInterface : featureInterfaces( message.featureUid() ) )
 	{
 		if( featureInterface->handleFeatureMessage( server, messageContext, message ) )
 		{
@@ -218,7 +283,7 @@ bool FeatureManager::handleFeatureMessage( VeyonWorkerInterface& worker, const F
 
 	bool handled = false;
 
-	for( const auto& featureInterface : qAsConst( m_featurePluginInterfaces ) )
+	for( const auto& featureInterface : featureInterfaces( message.featureUid() ) )
 	{
 		if( featureInterface->handleFeatureMessage( worker, message ) )
 		{
@@ -228,3 +293,17 @@ bool FeatureManager::handleFeatureMessage( VeyonWorkerInterface& worker, const F
 
 	return handled;
 }
+
+
+
+FeatureProviderInterfaceList FeatureManager::featureInterfaces( Feature::Uid featureUid ) const
+{
+	const auto featureInterface = m_featureInterfaces.value( featureUid );
+	if( featureInterface )
+	{
+		return { featureInterface };
+	}
+
+	// messages of features not listed by any plugin are offered to all plugins
+	return m_featurePluginInterfaces;
+}
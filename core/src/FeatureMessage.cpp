@@ -22,58 +22,371 @@
  *
  */
 
+#include <limits>
+
+#include <QBuffer>
+#include <QDataStream>
+#include <QtEndian>
+
 #include "FeatureMessage.h"
 #include "VariantArrayMessage.h"
+#include "VariantStream.h"
+
 
+namespace {
 
-bool FeatureMessage::send( QIODevice* ioDevice ) const
+enum class BinaryValueType : quint8
 {
-	if( ioDevice )
+	Invalid,
+	Bool,
+	Int,
+	UInt,
+	LongLong,
+	ULongLong,
+	Double,
+	String,
+	ByteArray,
+	Uuid,
+	StringList,
+	Variant
+};
+
+constexpr auto InternedArgumentKeyCount = 32;
+
+
+const QString& internedArgumentKey( int key )
+{
+	static const auto keys = []() {
+		QStringList list;
+		list.reserve( InternedArgumentKeyCount );
+		for( int i = 0; i < InternedArgumentKeyCount; ++i )
+		{
+			list.append( QString::number( i ) );
+		}
+		return list;
+	}();
+
+	return keys[key];
+}
+
+
+
+void writeBinaryValue( QDataStream& stream, const QVariant& value )
+{
+	switch( value.userType() )
 	{
-		VariantArrayMessage message( ioDevice );
+	case QMetaType::UnknownType:
+		stream << static_cast<quint8>( BinaryValueType::Invalid );
+		break;
+	case QMetaType::Bool:
+		stream << static_cast<quint8>( BinaryValueType::Bool ) << value.toBool();
+		break;
+	case QMetaType::Int:
+		stream << static_cast<quint8>( BinaryValueType::Int ) << value.toInt();
+		break;
+	case QMetaType::UInt:
+		stream << static_cast<quint8>( BinaryValueType::UInt ) << value.toUInt();
+		break;
+	case QMetaType::LongLong:
+		stream << static_cast<quint8>( BinaryValueType::LongLong ) << value.toLongLong();
+		break;
+	case QMetaType::ULongLong:
+		stream << static_cast<quint8>( BinaryValueType::ULongLong ) << value.toULongLong();
+		break;
+	case QMetaType::Double:
+		stream << static_cast<quint8>( BinaryValueType::Double ) << value.toDouble();
+		break;
+	case QMetaType::QString:
+		stream << static_cast<quint8>( BinaryValueType::String ) << value.toString().toUtf8();
+		break;
+	case QMetaType::QByteArray:
+		stream << static_cast<quint8>( BinaryValueType::ByteArray ) << value.toByteArray();
+		break;
+	case QMetaType::QUuid:
+		stream << static_cast<quint8>( BinaryValueType::Uuid ) << value.toUuid();
+		break;
+	case QMetaType::QStringList:
+	{
+		const auto list = value.toStringList();
+		stream << static_cast<quint8>( BinaryValueType::StringList ) << static_cast<quint32>( list.size() );
+		for( const auto& string : list )
+		{
+			stream << string.toUtf8();
+		}
+		break;
+	}
+	default:
+		stream << static_cast<quint8>( BinaryValueType::Variant ) << value;
+		break;
+	}
+}
+
 
-		message.write( m_featureUid );
-		message.write( m_command );
-		message.write( m_arguments );
 
-		return message.send();
+bool readBinaryValue( QDataStream& stream, QVariant& value )
+{
+	quint8 type = 0;
+	stream >> type;
+
+	switch( static_cast<BinaryValueType>( type ) )
+	{
+	case BinaryValueType::Invalid: value = QVariant(); break;
+	case BinaryValueType::Bool: { bool v; stream >> v; value = v; break; }
+	case BinaryValueType::Int: { qint32 v; stream >> v; value = v; break; }
+	case BinaryValueType::UInt: { quint32 v; stream >> v; value = v; break; }
+	case BinaryValueType::LongLong: { qint64 v; stream >> v; value = v; break; }
+	case BinaryValueType::ULongLong: { quint64 v; stream >> v; value = v; break; }
+	case BinaryValueType::Double: { double v; stream >> v; value = v; break; }
+	case BinaryValueType::String: { QByteArray v; stream >> v; value = QString::fromUtf8( v ); break; }
+	case BinaryValueType::ByteArray: { QByteArray v; stream >> v; value = v; break; }
+	case BinaryValueType::Uuid: { QUuid v; stream >> v; value = v; break; }
+	case BinaryValueType::StringList:
+	{
+		quint32 count = 0;
+		stream >> count;
+
+		QStringList list;
+		for( quint32 i = 0; i < count && stream.status() == QDataStream::Ok; ++i )
+		{
+			QByteArray string;
+			stream >> string;
+			list.append( QString::fromUtf8( string ) );
+		}
+		value = list;
+		break;
+	}
+	case BinaryValueType::Variant: stream >> value; break;
+	default:
+		vWarning() << "invalid value type" << type;
+		return false;
 	}
 
-	vCritical() << "no IO device!";
+	return stream.status() == QDataStream::Ok;
+}
 
-	return false;
+}
+
+
+
+bool FeatureMessage::send( QIODevice* ioDevice, WireFormat wireFormat ) const
+{
+	if( ioDevice == nullptr )
+	{
+		vCritical() << "no IO device!";
+		return false;
+	}
+
+	const auto frame = encode( wireFormat );
+
+	return ioDevice->write( frame ) == frame.size();
+}
+
+
+
+QByteArray FeatureMessage::encode( WireFormat wireFormat ) const
+{
+	if( wireFormat != WireFormat::Legacy )
+	{
+		const auto frame = encodeBinary();
+		if( frame.isEmpty() == false )
+		{
+			return frame;
+		}
+	}
+
+	QBuffer buffer;
+	buffer.open( QBuffer::WriteOnly ); // Flawfinder: ignore
+
+	VariantArrayMessage message( &buffer );
+
+	message.write( m_featureUid );
+	message.write( m_command );
+	message.write( m_arguments );
+	message.send();
+
+	return buffer.data();
 }
 
 
 
 bool FeatureMessage::isReadyForReceive( QIODevice* ioDevice )
 {
-	return ioDevice != nullptr &&
-			VariantArrayMessage( ioDevice ).isReadyForReceive();
+	MessageSize messageSize;
+
+	if( ioDevice &&
+		ioDevice->peek( reinterpret_cast<char *>( &messageSize ), sizeof(messageSize) ) == sizeof(messageSize) )
+	{
+		messageSize = qFromBigEndian( messageSize ) & ~BinaryFrameFlag;
+
+		return ioDevice->bytesAvailable() >= static_cast<qint64>( sizeof(messageSize) + messageSize );
+	}
+
+	return false;
 }
 
 
 
 bool FeatureMessage::receive( QIODevice* ioDevice )
 {
-	if( ioDevice != nullptr )
+	if( ioDevice == nullptr )
+	{
+		vCritical() << "no IO device!";
+		return false;
+	}
+
+	MessageSize messageSize;
+
+	if( ioDevice->read( reinterpret_cast<char *>( &messageSize ), sizeof(messageSize) ) != sizeof(messageSize) ) // Flawfinder: ignore
 	{
-		VariantArrayMessage message( ioDevice );
+		vWarning() << "could not read message size!";
+		return false;
+	}
 
-		if( message.receive() )
+	messageSize = qFromBigEndian( messageSize );
+
+	const auto isBinary = ( messageSize & BinaryFrameFlag ) != 0;
+	messageSize &= ~BinaryFrameFlag;
+
+	if( messageSize > MaxMessageSize )
+	{
+		vCritical() << "invalid message size" << messageSize;
+		return false;
+	}
+
+	const auto data = ioDevice->read( messageSize ); // Flawfinder: ignore
+	if( data.size() != static_cast<qint64>( messageSize ) )
+	{
+		vWarning() << "could not read message data!";
+		return false;
+	}
+
+	if( isBinary ? decodeBinary( data ) : decodeLegacy( data ) )
+	{
+		return true;
+	}
+
+	vWarning() << "could not receive message!";
+
+	return false;
+}
+
+
+
+FeatureMessage::WireFormat FeatureMessage::negotiatedWireFormat( const FeatureMessage& message )
+{
+	const auto peerSchemaVersion = message.argument( WireFormatArgument::SchemaVersion ).toInt();
+
+	return static_cast<WireFormat>( qBound( static_cast<int>( WireFormat::Legacy ),
+											peerSchemaVersion,
+											static_cast<int>( WireFormat::Latest ) ) );
+}
+
+
+
+QByteArray FeatureMessage::encodeBinary() const
+{
+	QByteArray frame;
+	frame.reserve( 64 );
+
+	QDataStream stream( &frame, QIODevice::WriteOnly );
+	stream.setVersion( QDataStream::Qt_5_5 );
+
+	// placeholder for frame header
+	stream << MessageSize( 0 );
+
+	stream << static_cast<quint8>( WireFormat::BinaryV1 ) << m_featureUid << m_command
+		   << static_cast<ArgumentKey>( m_arguments.size() );
+
+	for( auto it = m_arguments.constBegin(), end = m_arguments.constEnd(); it != end; ++it )
+	{
+		bool ok = false;
+		const auto key = it.key().toUInt( &ok );
+
+		// only keys generated by addArgument() can be interned
+		if( ok == false || key > std::numeric_limits<ArgumentKey>::max() || QString::number( key ) != it.key() )
 		{
-			m_featureUid = message.read().toUuid(); // Flawfinder: ignore
-			m_command = message.read().value<Command>(); // Flawfinder: ignore
-			m_arguments = message.read().toMap(); // Flawfinder: ignore
-			return true;
+			return {};
 		}
 
-		vWarning() << "could not receive message!";
+		stream << static_cast<ArgumentKey>( key );
+		writeBinaryValue( stream, it.value() );
 	}
-	else
+
+	const auto payloadSize = static_cast<MessageSize>( frame.size() - sizeof(MessageSize) );
+	if( payloadSize > MaxMessageSize )
 	{
-		vCritical() << "no IO device!";
+		return {};
 	}
 
-	return false;
+	qToBigEndian<MessageSize>( payloadSize | BinaryFrameFlag, frame.data() );
+
+	return frame;
+}
+
+
+
+bool FeatureMessage::decodeBinary( const QByteArray& data )
+{
+	QDataStream stream( data );
+	stream.setVersion( QDataStream::Qt_5_5 );
+
+	quint8 schemaVersion = 0;
+	stream >> schemaVersion;
+
+	if( schemaVersion != static_cast<quint8>( WireFormat::BinaryV1 ) )
+	{
+		vWarning() << "unsupported schema version" << schemaVersion;
+		return false;
+	}
+
+	FeatureUid featureUid;
+	Command command = InvalidCommand;
+	ArgumentKey argumentCount = 0;
+
+	stream >> featureUid >> command >> argumentCount;
+
+	Arguments arguments;
+
+	for( ArgumentKey i = 0; i < argumentCount; ++i )
+	{
+		ArgumentKey key = 0;
+		stream >> key;
+
+		QVariant value;
+		if( stream.status() != QDataStream::Ok || readBinaryValue( stream, value ) == false )
+		{
+			return false;
+		}
+
+		arguments.insert( key < InternedArgumentKeyCount ? internedArgumentKey( key ) : QString::number( key ),
+						  value );
+	}
+
+	if( stream.status() != QDataStream::Ok )
+	{
+		return false;
+	}
+
+	m_featureUid = featureUid;
+	m_command = command;
+	m_arguments = arguments;
+
+	return true;
+}
+
+
+
+bool FeatureMessage::decodeLegacy( const QByteArray& data )
+{
+	QBuffer buffer;
+	buffer.setData( data );
+	buffer.open( QBuffer::ReadOnly ); // Flawfinder: ignore
+
+	VariantStream stream( &buffer );
+
+	m_featureUid = stream.read().toUuid(); // Flawfinder: ignore
+	m_command = stream.read().value<Command>(); // Flawfinder: ignore
+	m_arguments = stream.read().toMap(); // Flawfinder: ignore
+
+	return true;
 }
@@ -22,6 +22,8 @@
  *
  */
 
+#include <algorithm>
+
 #include <QCoreApplication>
 #include <QDir>
 #include <QThread>
@@ -34,6 +36,7 @@
 #include "VeyonCore.h"
 #include "PlatformCoreFunctions.h"
 #include "PlatformUserFunctions.h"
+#include "VeyonServerInterface.h"
 
 // clazy:excludeall=detaching-member
 
@@ -41,34 +44,59 @@ FeatureWorkerManager::FeatureWorkerManager( VeyonServerInterface& server, Featur
 	QObject( parent ),
 	m_server( server ),
 	m_featureManager( featureManager ),
-	m_tcpServer( this )
+	m_localServer( this ),
+	m_workerPoolRetryTimer( this )
 {
-	connect( &m_tcpServer, &QTcpServer::newConnection,
+	connect( &m_localServer, &QLocalServer::newConnection,
 			 this, &FeatureWorkerManager::acceptConnection );
 
-	if( !m_tcpServer.listen( QHostAddress::LocalHost,
-							 static_cast<quint16>( VeyonCore::config().featureWorkerManagerPort() + VeyonCore::sessionId() ) ) )
-	{
-		vCritical() << "can't listen on localhost!";
-	}
+	// replace pooled workers which exited unexpectedly but do not restart crashing workers over and over
+	m_workerPoolRetryTimer.setInterval( WorkerPoolRetryInterval );
+	m_workerPoolRetryTimer.setSingleShot( true );
+	connect( &m_workerPoolRetryTimer, &QTimer::timeout, this, &FeatureWorkerManager::fillWorkerPool );
+
+	const auto name = serverName( m_server.sessionId() );
 
-	auto pendingMessagesTimer = new QTimer( this );
-	connect( pendingMessagesTimer, &QTimer::timeout, this, &FeatureWorkerManager::sendPendingMessages );
+	// remove stale socket file of a crashed server
+	QLocalServer::removeServer( name );
 
-	pendingMessagesTimer->start( 100 );
+	// workers running in user context have to be able to connect
+	m_localServer.setSocketOptions( QLocalServer::WorldAccessOption );
+
+	if( m_localServer.listen( name ) == false )
+	{
+		vCritical() << "can't listen on local socket" << name << m_localServer.errorString();
+	}
+	else
+	{
+		// start pooled workers once the session has settled
+		QTimer::singleShot( WorkerPoolStartDelay, this, &FeatureWorkerManager::fillWorkerPool );
+	}
 }
 
 
 
 FeatureWorkerManager::~FeatureWorkerManager()
 {
-	m_tcpServer.close();
+	// do not notify about workers being stopped while the server is shutting down
+	disconnect( this, &FeatureWorkerManager::runningWorkersChanged, nullptr, nullptr );
+
+	m_localServer.close();
 
 	// properly shutdown all worker processes
 	while( m_workers.isEmpty() == false )
 	{
 		stopWorker( Feature( m_workers.firstKey() ) );
 	}
+
+	stopPooledWorkers();
+}
+
+
+
+QString FeatureWorkerManager::serverName( int sessionId )
+{
+	return QStringLiteral("VeyonFeatureWorkerManager-%1").arg( VeyonCore::config().featureWorkerManagerPort() + sessionId );
 }
 
 
@@ -93,10 +121,15 @@ void FeatureWorkerManager::startWorker( const Feature& feature, WorkerProcessMod
 
 	Worker worker;
 
-	if( workerProcessMode == ManagedSystemProcess )
+	if( workerProcessMode == ManagedSystemProcess && assignPooledWorker( feature, worker ) )
+	{
+		vDebug() << "Assigned pooled worker to feature" << feature.name() << featureUid;
+	}
+	else if( workerProcessMode == ManagedSystemProcess )
 	{
 		worker.process = new QProcess;
 		worker.process->setProcessChannelMode( QProcess::ForwardedChannels );
+		worker.process->setProcessEnvironment( m_server.sessionEnvironment() );
 
 		connect( worker.process, static_cast<void(QProcess::*)(int, QProcess::ExitStatus)>(&QProcess::finished),
 				 worker.process, &QProcess::deleteLater );
@@ -107,10 +140,18 @@ void FeatureWorkerManager::startWorker( const Feature& feature, WorkerProcessMod
 	else
 	{
 		vDebug() << "Starting worker (unmanaged session process) for feature" << feature.name() << featureUid;
+
+		auto sessionUser = m_server.sessionUser();
+		if( sessionUser.isEmpty() )
+		{
+			sessionUser = VeyonCore::platform().userFunctions().currentUser();
+		}
+
 		const auto ret = VeyonCore::platform().coreFunctions().
 				runProgramAsUser( VeyonCore::filesystem().workerFilePath(), { featureUid },
-								  VeyonCore::platform().userFunctions().currentUser(),
-								  VeyonCore::platform().coreFunctions().activeDesktopName() );
+								  sessionUser,
+								  VeyonCore::platform().coreFunctions().activeDesktopName(),
+								  m_server.sessionEnvironment() );
 		if( ret == false )
 		{
 			vDebug() << "User session likely not yet available - retrying worker start";
@@ -123,6 +164,8 @@ void FeatureWorkerManager::startWorker( const Feature& feature, WorkerProcessMod
 	m_workersMutex.lock();
 	m_workers[feature.uid()] = worker;
 	m_workersMutex.unlock();
+
+	emit runningWorkersChanged();
 }
 
 
@@ -142,7 +185,8 @@ void FeatureWorkerManager::stopWorker( const Feature &feature )
 
 	m_workersMutex.lock();
 
-	if( m_workers.contains( feature.uid() ) )
+	const auto workerRunning = m_workers.contains( feature.uid() );
+	if( workerRunning )
 	{
 		vDebug() << "Stopping worker for feature" << feature.name() << feature.uid();
 
@@ -170,6 +214,11 @@ void FeatureWorkerManager::stopWorker( const Feature &feature )
 	}
 
 	m_workersMutex.unlock();
+
+	if( workerRunning )
+	{
+		emit runningWorkersChanged();
+	}
 }
 
 
@@ -180,7 +229,25 @@ void FeatureWorkerManager::sendMessage( const FeatureMessage& message )
 
 	if( m_workers.contains( message.featureUid() ) )
 	{
-		m_workers[message.featureUid()].pendingMessages.append( message );
+		auto& worker = m_workers[message.featureUid()];
+		worker.pendingMessages.append( message );
+
+		// messages for workers not connected yet are sent as soon as the worker has connected
+		if( worker.socket )
+		{
+			if( thread() == QThread::currentThread() )
+			{
+				sendPendingMessages( worker );
+			}
+			else
+			{
+#if QT_VERSION >= QT_VERSION_CHECK(5, 10, 0)
+				QMetaObject::invokeMethod( this, [this]() { sendPendingMessages(); }, Qt::QueuedConnection );
+#else
+				QMetaObject::invokeMethod( this, "sendPendingMessages", Qt::QueuedConnection );
+#endif
+			}
+		}
 	}
 
 	m_workersMutex.unlock();
@@ -217,38 +284,74 @@ void FeatureWorkerManager::acceptConnection()
 {
 	vDebug() << "accepting connection";
 
-	QTcpSocket* socket = m_tcpServer.nextPendingConnection();
+	QLocalSocket* socket = m_localServer.nextPendingConnection();
 
 	// connect to readyRead() signal of new connection
-	connect( socket, &QTcpSocket::readyRead,
+	connect( socket, &QLocalSocket::readyRead,
 			 this, [=] () { processConnection( socket ); } );
 
-	connect( socket, &QTcpSocket::disconnected,
+	connect( socket, &QLocalSocket::disconnected,
 			 this, [=] () { closeConnection( socket ); } );
 }
 
 
 
-void FeatureWorkerManager::processConnection( QTcpSocket* socket )
+void FeatureWorkerManager::processConnection( QLocalSocket* socket )
 {
 	FeatureMessage message;
-	message.receive( socket );
+
+	// drain all complete messages as readyRead() is not emitted again for already buffered data
+	while( message.isReadyForReceive( socket ) )
+	{
+		if( message.receive( socket ) )
+		{
+			processMessage( socket, message );
+		}
+	}
+}
+
+
+
+void FeatureWorkerManager::processMessage( QLocalSocket* socket, const FeatureMessage& message )
+{
+	if( message.featureUid().isNull() && message.command() == FeatureMessage::InitCommand )
+	{
+		registerPooledWorker( socket, message );
+		return;
+	}
 
 	m_workersMutex.lock();
 
 	// set socket information
 	if( m_workers.contains( message.featureUid() ) )
 	{
-		if( m_workers[message.featureUid()].socket.isNull() )
+		auto& worker = m_workers[message.featureUid()];
+		if( worker.socket.isNull() )
 		{
-			m_workers[message.featureUid()].socket = socket;
+			worker.socket = socket;
 		}
 
+		if( message.command() == FeatureMessage::InitCommand )
+		{
+			worker.wireFormat = FeatureMessage::negotiatedWireFormat( message );
+
+			// workers not supporting negotiation do not expect a reply
+			if( worker.wireFormat != FeatureMessage::WireFormat::Legacy )
+			{
+				FeatureMessage( message.featureUid(), FeatureMessage::NegotiateWireFormatCommand )
+						.addWireFormatArgument( worker.wireFormat ).send( socket );
+			}
+
+			sendPendingMessages( worker );
+		}
+
+		const auto wireFormat = worker.wireFormat;
+
 		m_workersMutex.unlock();
 
 		if( message.command() >= 0 )
 		{
-			m_featureManager.handleFeatureMessage( m_server, MessageContext( socket ), message );
+			m_featureManager.handleFeatureMessage( m_server, MessageContext( socket, wireFormat ), message );
 		}
 
 	}
@@ -262,16 +365,19 @@ void FeatureWorkerManager::processConnection( QTcpSocket* socket )
 
 
 
-void FeatureWorkerManager::closeConnection( QTcpSocket* socket )
+void FeatureWorkerManager::closeConnection( QLocalSocket* socket )
 {
 	m_workersMutex.lock();
 
+	auto workersRemoved = false;
+
 	for( auto it = m_workers.begin(); it != m_workers.end(); )
 	{
 		if( it.value().socket == socket )
 		{
 			vDebug() << "removing worker after socket has been closed";
 			it = m_workers.erase( it );
+			workersRemoved = true;
 		}
 		else
 		{
@@ -281,6 +387,11 @@ void FeatureWorkerManager::closeConnection( QTcpSocket* socket )
 
 	m_workersMutex.unlock();
 
+	if( workersRemoved )
+	{
+		emit runningWorkersChanged();
+	}
+
 	socket->deleteLater();
 }
 
@@ -292,14 +403,156 @@ void FeatureWorkerManager::sendPendingMessages()
 
 	for( auto it = m_workers.begin(); it != m_workers.end(); ++it )
 	{
-		auto& worker = it.value();
+		sendPendingMessages( it.value() );
+	}
+
+	m_workersMutex.unlock();
+}
+
+
 
-		while( worker.socket && worker.pendingMessages.isEmpty() == false )
+void FeatureWorkerManager::sendPendingMessages( Worker& worker )
+{
+	while( worker.socket && worker.pendingMessages.isEmpty() == false )
+	{
+		worker.pendingMessages.first().send( worker.socket, worker.wireFormat );
+		worker.pendingMessages.removeFirst();
+	}
+}
+
+
+
+void FeatureWorkerManager::fillWorkerPool()
+{
+	for( auto it = m_workerPool.begin(); it != m_workerPool.end(); )
+	{
+		if( it->process.isNull() )
+		{
+			it = m_workerPool.erase( it );
+		}
+		else
 		{
-			worker.pendingMessages.first().send( worker.socket );
-			worker.pendingMessages.removeFirst();
+			++it;
 		}
 	}
 
-	m_workersMutex.unlock();
+	while( m_workerPool.size() < VeyonCore::config().featureWorkerPoolSize() )
+	{
+		PooledWorker pooledWorker;
+		pooledWorker.process = new QProcess;
+		pooledWorker.process->setProcessChannelMode( QProcess::ForwardedChannels );
+		pooledWorker.process->setProcessEnvironment( m_server.sessionEnvironment() );
+
+		connect( pooledWorker.process, static_cast<void(QProcess::*)(int, QProcess::ExitStatus)>(&QProcess::finished),
+				 pooledWorker.process, &QProcess::deleteLater );
+
+		const auto process = pooledWorker.process.data();
+		connect( process, static_cast<void(QProcess::*)(int, QProcess::ExitStatus)>(&QProcess::finished),
+				 this, [=]( int exitCode, QProcess::ExitStatus exitStatus ) {
+			const auto stillPooled = std::any_of( m_workerPool.cbegin(), m_workerPool.cend(),
+												  [process]( const PooledWorker& worker ) { return worker.process == process; } );
+			if( stillPooled && m_workerPoolRetryTimer.isActive() == false )
+			{
+				vWarning() << "pooled worker exited unexpectedly with code" << exitCode << exitStatus;
+				m_workerPoolRetryTimer.start();
+			}
+		} );
+
+		vDebug() << "Starting pooled worker";
+		pooledWorker.process->start( VeyonCore::filesystem().workerFilePath(), { pooledWorkerArgument() } );
+
+		m_workerPool.append( pooledWorker );
+	}
+}
+
+
+
+void FeatureWorkerManager::registerPooledWorker( QLocalSocket* socket, const FeatureMessage& message )
+{
+	const auto processId = message.argument( PooledWorkerArgument::ProcessId ).toLongLong();
+
+	for( auto& pooledWorker : m_workerPool )
+	{
+		if( pooledWorker.process && pooledWorker.process->processId() == processId )
+		{
+			pooledWorker.socket = socket;
+			pooledWorker.wireFormat = FeatureMessage::negotiatedWireFormat( message );
+
+			if( pooledWorker.wireFormat != FeatureMessage::WireFormat::Legacy )
+			{
+				FeatureMessage( Feature::Uid(), FeatureMessage::NegotiateWireFormatCommand )
+						.addWireFormatArgument( pooledWorker.wireFormat ).send( socket );
+			}
+
+			vDebug() << "pooled worker" << processId << "ready";
+			return;
+		}
+	}
+
+	vWarning() << "closing connection of unknown pooled worker" << processId;
+	socket->close();
+}
+
+
+
+void FeatureWorkerManager::stopPooledWorkers()
+{
+	// pooled workers have not been assigned to any feature yet so terminate all of them at once
+	for( const auto& pooledWorker : qAsConst( m_workerPool ) )
+	{
+		if( pooledWorker.socket )
+		{
+			pooledWorker.socket->disconnect( this );
+			pooledWorker.socket->close();
+		}
+
+		if( pooledWorker.process )
+		{
+			pooledWorker.process->disconnect( this );
+			pooledWorker.process->terminate();
+		}
+	}
+
+	for( const auto& pooledWorker : qAsConst( m_workerPool ) )
+	{
+		if( pooledWorker.process )
+		{
+			if( pooledWorker.process->waitForFinished( PooledWorkerStopTimeout ) == false )
+			{
+				vWarning() << "killing pooled worker" << pooledWorker.process->processId();
+				pooledWorker.process->kill();
+				pooledWorker.process->waitForFinished( PooledWorkerStopTimeout );
+			}
+
+			delete pooledWorker.process;
+		}
+	}
+
+	m_workerPool.clear();
+}
+
+
+
+bool FeatureWorkerManager::assignPooledWorker( const Feature& feature, Worker& worker )
+{
+	for( auto it = m_workerPool.begin(); it != m_workerPool.end(); ++it )
+	{
+		if( it->process && it->socket && it->socket->state() == QLocalSocket::ConnectedState )
+		{
+			worker.process = it->process;
+			worker.socket = it->socket;
+			worker.wireFormat = it->wireFormat;
+
+			// the worker initializes the feature and then sends a regular init message
+			FeatureMessage( feature.uid(), FeatureMessage::AssignFeatureCommand ).send( worker.socket, worker.wireFormat );
+
+			m_workerPool.erase( it );
+
+			QTimer::singleShot( WorkerPoolRefillDelay, this, &FeatureWorkerManager::fillWorkerPool );
+
+			return true;
+		}
+	}
+
+	return false;
 }
@@ -22,8 +22,11 @@
  *
  */
 
+#include <algorithm>
+
 #include <QtConcurrent>
 
+#include "FeatureWorkerManager.h"
 #include "MonitoringMode.h"
 #include "PlatformUserFunctions.h"
 #include "VeyonServerInterface.h"
@@ -50,7 +53,15 @@ MonitoringMode::MonitoringMode( QObject* parent ) :
 
 bool MonitoringMode::queryLoggedOnUserInfo( const ComputerControlInterfaceList& computerControlInterfaces )
 {
-	return sendFeatureMessage( FeatureMessage( m_queryLoggedOnUserInfoFeature.uid(), FeatureMessage::DefaultCommand ),
+	return sendFeatureMessage( FeatureMessage( m_queryLoggedOnUserInfoFeature.uid(), QueryUserInfo ),
+							   computerControlInterfaces, false );
+}
+
+
+
+bool MonitoringMode::subscribeLoggedOnUserInfo( const ComputerControlInterfaceList& computerControlInterfaces )
+{
+	return sendFeatureMessage( FeatureMessage( m_queryLoggedOnUserInfoFeature.uid(), SubscribeUserInfo ),
 							   computerControlInterfaces, false );
 }
 
@@ -66,6 +77,12 @@ bool MonitoringMode::handleFeatureMessage( VeyonMasterInterface& master, const F
 		computerControlInterface->setUserLoginName( message.argument( UserLoginName ).toString() );
 		computerControlInterface->setUserFullName( message.argument( UserFullName ).toString() );
 
+		if( message.command() == SubscribeUserInfo )
+		{
+			// servers without subscription support reply without this argument
+			computerControlInterface->setUserInfoSubscribed( message.argument( Subscribed ).toBool() );
+		}
+
 		return true;
 	}
 
@@ -82,19 +99,39 @@ bool MonitoringMode::handleFeatureMessage( VeyonServerInterface& server,
 	{
 		FeatureMessage reply( message.featureUid(), message.command() );
 
+		const auto sessionUser = server.sessionUser();
+
 		m_userDataLock.lockForRead();
-		if( m_userLoginName.isEmpty() )
+		const auto userInfo = m_userInfo.value( sessionUser );
+		m_userDataLock.unlock();
+
+		if( userInfo.loginName.isEmpty() )
 		{
-			queryUserInformation();
+			if( message.command() == SubscribeUserInfo )
+			{
+				const auto alreadySubscribed = std::any_of( m_subscribers.constBegin(), m_subscribers.constEnd(),
+															[&]( const Subscriber& subscriber ) {
+					return subscriber.messageContext.ioDevice() == messageContext.ioDevice(); } );
+				if( alreadySubscribed == false )
+				{
+					m_subscribers.append( { &server, &server.featureWorkerManager(), messageContext } );
+				}
+			}
+
+			queryUserInformation( sessionUser );
 			reply.addArgument( UserLoginName, QString() );
 			reply.addArgument( UserFullName, QString() );
 		}
 		else
 		{
-			reply.addArgument( UserLoginName, m_userLoginName );
-			reply.addArgument( UserFullName, m_userFullName );
+			reply.addArgument( UserLoginName, userInfo.loginName );
+			reply.addArgument( UserFullName, userInfo.fullName );
+		}
+
+		if( message.command() == SubscribeUserInfo )
+		{
+			reply.addArgument( Subscribed, true );
 		}
-		m_userDataLock.unlock();
 
 		return server.sendFeatureMessageReply( messageContext, reply );
 	}
@@ -104,16 +141,53 @@ bool MonitoringMode::handleFeatureMessage( VeyonServerInterface& server,
 
 
 
-void MonitoringMode::queryUserInformation()
+void MonitoringMode::queryUserInformation( const QString& sessionUser )
 {
 	// asynchronously query information about logged on user (which might block
 	// due to domain controller queries and timeouts etc.)
 	QtConcurrent::run( [=]() {
-		const auto userLoginName = VeyonCore::platform().userFunctions().currentUser();
+		const auto userLoginName = sessionUser.isEmpty() ? VeyonCore::platform().userFunctions().currentUser()
+														 : sessionUser;
 		const auto userFullName = VeyonCore::platform().userFunctions().fullName( userLoginName );
 		m_userDataLock.lockForWrite();
-		m_userLoginName = userLoginName;
-		m_userFullName = userFullName;
+		m_userInfo[sessionUser] = { userLoginName, userFullName };
 		m_userDataLock.unlock();
+
+#if QT_VERSION >= QT_VERSION_CHECK(5, 10, 0)
+		QMetaObject::invokeMethod( this, [=]() { pushUserInformation( sessionUser ); }, Qt::QueuedConnection );
+#else
+		QMetaObject::invokeMethod( this, "pushUserInformation", Qt::QueuedConnection,
+								   Q_ARG( QString, sessionUser ) );
+#endif
 	} );
 }
+
+
+
+void MonitoringMode::pushUserInformation( const QString& sessionUser )
+{
+	m_userDataLock.lockForRead();
+	const auto userInfo = m_userInfo.value( sessionUser );
+	m_userDataLock.unlock();
+
+	for( auto it = m_subscribers.begin(); it != m_subscribers.end(); )
+	{
+		if( it->messageContext.ioDevice() == nullptr || it->featureWorkerManager.isNull() )
+		{
+			it = m_subscribers.erase( it );
+		}
+		else if( it->server->sessionUser() == sessionUser )
+		{
+			it->server->sendFeatureMessageReply( it->messageContext,
+												 FeatureMessage( m_queryLoggedOnUserInfoFeature.uid(), SubscribeUserInfo )
+													 .addArgument( UserLoginName, userInfo.loginName )
+													 .addArgument( UserFullName, userInfo.fullName )
+													 .addArgument( Subscribed, true ) );
+			it = m_subscribers.erase( it );
+		}
+		else
+		{
+			++it;
+		}
+	}
+}
@@ -33,6 +33,7 @@ NetworkObjectDirectory::NetworkObjectDirectory( QObject* parent ) :
 	QObject( parent ),
 	m_updateTimer( new QTimer( this ) ),
 	m_objects(),
+	m_parentIds(),
 	m_invalidObject( NetworkObject::Type::None ),
 	m_rootObject( NetworkObject::Type::Root ),
 	m_defaultObjectList()
@@ -155,25 +156,7 @@ NetworkObject::ModelId NetworkObjectDirectory::childId( NetworkObject::ModelId p
 
 NetworkObject::ModelId NetworkObjectDirectory::parentId( NetworkObject::ModelId child ) const
 {
-	if( child == rootId() )
-	{
-		return 0;
-	}
-
-	for( auto it = m_objects.constBegin(); it != m_objects.constEnd(); ++it )
-	{
-		const auto& objectList = it.value();
-
-		for( const auto& object : objectList )
-		{
-			if( object.modelId() == child )
-			{
-				return it.key();
-			}
-		}
-	}
-
-	return 0;
+	return m_parentIds.value( child, 0 );
 }
 
 
@@ -287,6 +270,7 @@ void NetworkObjectDirectory::addOrUpdateObject( const NetworkObject& networkObje
 		emit objectsAboutToBeInserted( parent, objectList.count(), 1 );
 
 		objectList.append( completeNetworkObject );
+		m_parentIds[completeNetworkObject.modelId()] = parent.modelId();
 		if( completeNetworkObject.type() == NetworkObject::Type::Location )
 		{
 			m_objects[completeNetworkObject.modelId()] = {};
@@ -324,6 +308,7 @@ void NetworkObjectDirectory::removeObjects( const NetworkObject& parent, const N
 			}
 
 			emit objectsAboutToBeRemoved( parent, index, 1 );
+			m_parentIds.remove( it->modelId() );
 			it = objectList.erase( it );
 			emit objectsRemoved();
 		}
@@ -336,6 +321,10 @@ void NetworkObjectDirectory::removeObjects( const NetworkObject& parent, const N
 
 	for( const auto& groupId : groupsToRemove )
 	{
+		for( const auto& object : qAsConst( m_objects[groupId] ) )
+		{
+			m_parentIds.remove( object.modelId() );
+		}
 		m_objects.remove( groupId );
 	}
 }
@@ -22,14 +22,66 @@
  *
  */
 
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+
 #include "PlatformServiceCore.h"
 #include "VeyonConfiguration.h"
 
 
 
 PlatformServiceCore::PlatformServiceCore() :
-	m_multiSession( VeyonCore::config().multiSessionModeEnabled() )
+	m_multiSession( VeyonCore::config().multiSessionModeEnabled() ),
+	m_sharedServer( m_multiSession && VeyonCore::config().multiSessionSharedServerEnabled() )
+{
+}
+
+
+
+/*!
+ * \brief Encodes a command for a server process serving multiple sessions as a single line of text
+ */
+QByteArray PlatformServiceCore::encodeSharedServerCommand( SharedServerCommand command, SessionId sessionId,
+														   const QProcessEnvironment& sessionEnvironment )
 {
+	const QJsonObject commandObject{
+		{ QStringLiteral("command"), static_cast<int>( command ) },
+		{ QStringLiteral("session"), sessionId },
+		{ QStringLiteral("environment"), QJsonArray::fromStringList( sessionEnvironment.toStringList() ) }
+	};
+
+	return QJsonDocument( commandObject ).toJson( QJsonDocument::Compact ) + '\n';
+}
+
+
+
+PlatformServiceCore::SharedServerCommand PlatformServiceCore::decodeSharedServerCommand( const QByteArray& data,
+																						 SessionId& sessionId,
+																						 QProcessEnvironment& sessionEnvironment )
+{
+	const auto commandObject = QJsonDocument::fromJson( data ).object();
+	if( commandObject.isEmpty() )
+	{
+		return SharedServerCommand::InvalidCommand;
+	}
+
+	sessionId = commandObject.value( QStringLiteral("session") ).toInt( SessionIdInvalid );
+
+	sessionEnvironment.clear();
+
+	const auto environment = commandObject.value( QStringLiteral("environment") ).toArray();
+	for( const auto& variable : environment )
+	{
+		const auto variableString = variable.toString();
+		const auto separatorIndex = variableString.indexOf( QLatin1Char('=') );
+		if( separatorIndex > 0 )
+		{
+			sessionEnvironment.insert( variableString.left( separatorIndex ), variableString.mid( separatorIndex + 1 ) );
+		}
+	}
+
+	return static_cast<SharedServerCommand>( commandObject.value( QStringLiteral("command") ).toInt() );
 }
 
 
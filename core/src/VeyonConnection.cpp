@@ -52,6 +52,7 @@ rfbBool handleVeyonMessage( rfbClient* client, rfbServerToClientMsg* msg )
 
 VeyonConnection::VeyonConnection( VncConnection* vncConnection ):
 	m_vncConnection( vncConnection ),
+	m_featureMessageWireFormat( FeatureMessage::WireFormat::Legacy ),
 	m_user(),
 	m_userHomeDir()
 {
@@ -68,6 +69,8 @@ VeyonConnection::VeyonConnection( VncConnection* vncConnection ):
 	}
 
 	connect( m_vncConnection, &VncConnection::connectionPrepared, this, &VeyonConnection::registerConnection, Qt::DirectConnection );
+	connect( m_vncConnection, &VncConnection::connectionEstablished,
+			 this, &VeyonConnection::negotiateFeatureMessageWireFormat, Qt::DirectConnection );
 }
 
 
@@ -87,7 +90,20 @@ void VeyonConnection::sendFeatureMessage( const FeatureMessage& featureMessage,
 		return;
 	}
 
-	m_vncConnection->enqueueEvent( new VncFeatureMessageEvent( featureMessage ), wake );
+	m_vncConnection->enqueueEvent( new VncFeatureMessageEvent( featureMessage, m_featureMessageWireFormat ), wake );
+}
+
+
+
+void VeyonConnection::sendFeatureMessage( const FeatureMessage& featureMessage, const QByteArray& frame, bool wake )
+{
+	if( m_vncConnection.isNull() )
+	{
+		vCritical() << "cannot enqueue event as VNC connection is invalid";
+		return;
+	}
+
+	m_vncConnection->enqueueEvent( new VncFeatureMessageEvent( featureMessage, frame ), wake );
 }
 
 
@@ -105,6 +121,13 @@ bool VeyonConnection::handleServerMessage( rfbClient* client, uint8_t msg )
 			return false;
 		}
 
+		if( featureMessage.isWireFormatNegotiation() )
+		{
+			m_featureMessageWireFormat = FeatureMessage::negotiatedWireFormat( featureMessage );
+			vDebug() << "using feature message wire format" << static_cast<int>( m_featureMessageWireFormat.load() );
+			return true;
+		}
+
 		vDebug() << "received feature message" << featureMessage.command()
 			   << "with arguments" << featureMessage.arguments();
 
@@ -123,6 +146,22 @@ bool VeyonConnection::handleServerMessage( rfbClient* client, uint8_t msg )
 
 
 
+void VeyonConnection::negotiateFeatureMessageWireFormat()
+{
+	// servers not supporting negotiation ignore the request so keep sending legacy messages until confirmed
+	m_featureMessageWireFormat = FeatureMessage::WireFormat::Legacy;
+
+	if( m_vncConnection.isNull() == false )
+	{
+		m_vncConnection->enqueueEvent( new VncFeatureMessageEvent(
+										   FeatureMessage( FeatureMessage::FeatureUid(),
+														   FeatureMessage::NegotiateWireFormatCommand ).addWireFormatArgument() ),
+									   false );
+	}
+}
+
+
+
 void VeyonConnection::registerConnection()
 {
 	if( m_vncConnection.isNull() == false )
@@ -27,8 +27,20 @@
 #include "VncFeatureMessageEvent.h"
 
 
-VncFeatureMessageEvent::VncFeatureMessageEvent( const FeatureMessage& featureMessage ) :
-	m_featureMessage( featureMessage )
+VncFeatureMessageEvent::VncFeatureMessageEvent( const FeatureMessage& featureMessage,
+												FeatureMessage::WireFormat wireFormat ) :
+	m_featureMessage( featureMessage ),
+	m_wireFormat( wireFormat ),
+	m_frame()
+{
+}
+
+
+
+VncFeatureMessageEvent::VncFeatureMessageEvent( const FeatureMessage& featureMessage, const QByteArray& frame ) :
+	m_featureMessage( featureMessage ),
+	m_wireFormat( FeatureMessage::WireFormat::Legacy ),
+	m_frame( frame )
 {
 }
 
@@ -44,5 +56,12 @@ void VncFeatureMessageEvent::fire( rfbClient* client )
 	const char messageType = FeatureMessage::RfbMessageType;
 	socketDevice.write( &messageType, sizeof(messageType) );
 
-	m_featureMessage.send( &socketDevice );
+	if( m_frame.isEmpty() )
+	{
+		m_featureMessage.send( &socketDevice, m_wireFormat );
+	}
+	else
+	{
+		socketDevice.write( m_frame.constData(), m_frame.size() );
+	}
 }
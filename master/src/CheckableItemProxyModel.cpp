@@ -119,10 +119,15 @@ void CheckableItemProxyModel::updateNewRows(const QModelIndex &parent, int first
 	// also set newly inserted items checked if parent is checked
 	if( parent.isValid() && data( parent, Qt::CheckStateRole ).value<Qt::CheckState>() == Qt::Checked )
 	{
+		// the parent stays checked so only the new subtrees need to be updated, with one notification for all rows
 		for( int i = first; i <= last; ++i )
 		{
-			setData( index( i, 0, parent ), Qt::Checked, Qt::CheckStateRole );
+			const auto childIndex = index( i, 0, parent );
+			m_checkStates[indexToUuid( childIndex )] = Qt::Checked;
+			setChildData( childIndex, Qt::Checked );
 		}
+
+		emit dataChanged( index( first, 0, parent ), index( last, 0, parent ), { Qt::CheckStateRole } );
 	}
 }
 
@@ -22,7 +22,10 @@
  *
  */
 
+#include <algorithm>
+
 #include <QPainter>
+#include <QSet>
 
 #include "ComputerControlListModel.h"
 #include "ComputerManager.h"
@@ -42,7 +45,12 @@ ComputerControlListModel::ComputerControlListModel( VeyonMaster* masterCore, QOb
 	m_master( masterCore ),
 	m_iconDefault(),
 	m_iconConnectionProblem(),
-	m_iconDemoMode()
+	m_iconDemoMode(),
+	m_changesFlushTimer( this ),
+	m_screenCache( [this]( NetworkObject::Uid uid ) {
+		const auto controlInterface = computerControlInterface( uid );
+		return controlInterface ? controlInterface->scaledScreen() : QImage();
+	} )
 {
 #if defined(QT_TESTLIB_LIB) && QT_VERSION >= QT_VERSION_CHECK(5, 11, 0)
 	new QAbstractItemModelTester( this, QAbstractItemModelTester::FailureReportingMode::Warning, this );
@@ -50,6 +58,12 @@ ComputerControlListModel::ComputerControlListModel( VeyonMaster* masterCore, QOb
 
 	loadIcons();
 
+	m_changesFlushTimer.setInterval( ChangesFlushInterval );
+	m_changesFlushTimer.setSingleShot( true );
+	connect( &m_changesFlushTimer, &QTimer::timeout, this, &ComputerControlListModel::flushChanges );
+
+	connect( &m_screenCache, &ComputerScreenCache::screenLoaded, this, &ComputerControlListModel::updateStaleScreen );
+
 	connect( &m_master->computerManager(), &ComputerManager::computerSelectionReset,
 			 this, &ComputerControlListModel::reload );
 	connect( &m_master->computerManager(), &ComputerManager::computerSelectionChanged,
@@ -98,7 +112,7 @@ QVariant ComputerControlListModel::data( const QModelIndex& index, int role ) co
 		return computerDisplayRole( computerControl );
 
 	case Qt::InitialSortOrderRole:
-		return computerSortRole( computerControl );
+		return cachedSortKey( computerControl );
 
 	case UidRole:
 		return computerControl->computer().networkObjectUid();
@@ -107,9 +121,7 @@ QVariant ComputerControlListModel::data( const QModelIndex& index, int role ) co
 		return QVariant::fromValue( computerControl->state() );
 
 	case ImageIdRole:
-		return QStringLiteral("image://%1/%2/%3").arg( imageProviderId(),
-													   VeyonCore::formattedUuid( computerControl->computer().networkObjectUid() ),
-													   QString::number( computerControl->timestamp() ) );
+		return cachedImageId( computerControl );
 
 	case GroupsRole:
 		return computerControl->groups();
@@ -196,14 +208,13 @@ ComputerControlInterface::Pointer ComputerControlListModel::computerControlInter
 
 ComputerControlInterface::Pointer ComputerControlListModel::computerControlInterface( NetworkObject::Uid uid ) const
 {
-	for( auto& controlInterface : m_computerControlInterfaces )
+	const auto row = m_uidRows.value( uid, -1 );
+	if( row < 0 )
 	{
-		if( controlInterface->computer().networkObjectUid() == uid )
-		{
-			return controlInterface;
-		}
+		return {};
 	}
-	return {};
+
+	return m_computerControlInterfaces[row];
 }
 
 
@@ -212,21 +223,26 @@ void ComputerControlListModel::reload()
 {
 	beginResetModel();
 
-	const auto computerList = m_master->computerManager().selectedComputers( QModelIndex() );
+	const auto computerList = m_master->computerManager().selectedComputers();
+
+	m_screenCache.clear();
 
 	m_computerControlInterfaces.clear();
 	m_computerControlInterfaces.reserve( computerList.size() );
 
-	int row = 0;
-
 	for( const auto& computer : computerList )
 	{
 		const auto controlInterface = ComputerControlInterface::Pointer::create( computer );
 		m_computerControlInterfaces.append( controlInterface );
-		startComputerControlInterface( controlInterface, index( row ) );
-		++row;
+		startComputerControlInterface( controlInterface );
 	}
 
+	m_uidRows.clear();
+	updateUidRows();
+
+	m_changedRoles.clear();
+	m_cachedRoles.clear();
+
 	endResetModel();
 }
 
@@ -234,49 +250,154 @@ void ComputerControlListModel::reload()
 
 void ComputerControlListModel::update()
 {
-	const auto newComputerList = m_master->computerManager().selectedComputers( QModelIndex() );
+	const auto newComputerList = m_master->computerManager().selectedComputers();
 
-	int row = 0;
+	QSet<NetworkObject::Uid> newComputerUids;
+	QSet<QString> addedHostAddresses;
+	newComputerUids.reserve( newComputerList.size() );
 
-	for( auto it = m_computerControlInterfaces.begin(); it != m_computerControlInterfaces.end(); ) // clazy:exclude=detaching-member
+	for( const auto& computer : newComputerList )
 	{
-		if( newComputerList.contains( (*it)->computer() ) == false )
+		newComputerUids.insert( computer.networkObjectUid() );
+		if( m_uidRows.contains( computer.networkObjectUid() ) == false && computer.hostAddress().isEmpty() == false )
 		{
-			stopComputerControlInterface( *it );
+			addedHostAddresses.insert( computer.hostAddress() );
+		}
+	}
+
+	// interfaces of hosts which show up at another location are reused instead of reconnecting
+	QHash<QString, ComputerControlInterface::Pointer> movedComputerControlInterfaces;
 
-			beginRemoveRows( QModelIndex(), row, row );
-			it = m_computerControlInterfaces.erase( it );
-			endRemoveRows();
+	int firstChangedRow = m_computerControlInterfaces.count();
+
+	// remove contiguous ranges of deselected computers starting at the end so remaining rows do not shift
+	for( int last = m_computerControlInterfaces.count() - 1; last >= 0; )
+	{
+		if( newComputerUids.contains( m_computerControlInterfaces[last]->computer().networkObjectUid() ) )
+		{
+			--last;
+			continue;
 		}
-		else
+
+		int first = last;
+		while( first > 0 &&
+			   newComputerUids.contains( m_computerControlInterfaces[first-1]->computer().networkObjectUid() ) == false )
+		{
+			--first;
+		}
+
+		for( int row = first; row <= last; ++row )
 		{
-			++it;
-			++row;
+			const auto& controlInterface = m_computerControlInterfaces[row];
+			const auto& hostAddress = controlInterface->computer().hostAddress();
+
+			// remove screen first as pending screen updates are fetched via the row of the computer
+			m_screenCache.removeScreen( controlInterface->computer().networkObjectUid() );
+			m_uidRows.remove( controlInterface->computer().networkObjectUid() );
+			m_cachedRoles.remove( controlInterface->computer().networkObjectUid() );
+
+			if( addedHostAddresses.contains( hostAddress ) && movedComputerControlInterfaces.contains( hostAddress ) == false )
+			{
+				movedComputerControlInterfaces[hostAddress] = controlInterface;
+			}
+			else
+			{
+				stopComputerControlInterface( controlInterface );
+			}
 		}
+
+		beginRemoveRows( QModelIndex(), first, last );
+		m_computerControlInterfaces.erase( m_computerControlInterfaces.begin() + first, // clazy:exclude=detaching-member
+										   m_computerControlInterfaces.begin() + last + 1 ); // clazy:exclude=detaching-member
+		endRemoveRows();
+
+		firstChangedRow = first;
+		last = first - 1;
 	}
 
-	row = 0;
+	// insert contiguous ranges of newly selected computers at the positions given by the new list
+	int row = 0;
 
-	for( const auto& computer : newComputerList )
+	for( int i = 0; i < newComputerList.count(); )
 	{
-		if( row < m_computerControlInterfaces.count() && m_computerControlInterfaces[row]->computer() != computer )
+		if( m_uidRows.contains( newComputerList[i].networkObjectUid() ) )
 		{
-			beginInsertRows( QModelIndex(), row, row );
-			const auto controlInterface = ComputerControlInterface::Pointer::create( computer );
-			m_computerControlInterfaces.insert( row, controlInterface );
-			startComputerControlInterface( controlInterface, index( row ) );
-			endInsertRows();
+			if( row < m_computerControlInterfaces.count() && m_computerControlInterfaces[row]->computer() == newComputerList[i] )
+			{
+				++row;
+			}
+			++i;
+			continue;
 		}
-		else if( row >= m_computerControlInterfaces.count() )
+
+		int last = i;
+		while( last + 1 < newComputerList.count() &&
+			   m_uidRows.contains( newComputerList[last+1].networkObjectUid() ) == false )
+		{
+			++last;
+		}
+
+		const auto count = last - i + 1;
+
+		beginInsertRows( QModelIndex(), row, row + count - 1 );
+
+		m_computerControlInterfaces.insert( row, count, {} );
+
+		for( int insertRow = row; i <= last; ++i, ++insertRow )
 		{
-			beginInsertRows( QModelIndex(), row, row );
-			const auto controlInterface = ComputerControlInterface::Pointer::create( computer );
-			m_computerControlInterfaces.append( controlInterface );
-			startComputerControlInterface( controlInterface, index( row ) ); // clazy:exclude=detaching-member
-			endInsertRows();
+			const auto& computer = newComputerList[i];
+			auto controlInterface = movedComputerControlInterfaces.take( computer.hostAddress() );
+
+			if( controlInterface )
+			{
+				m_master->computerManager().updateUser( controlInterface->computer().networkObjectUid(), {} );
+				controlInterface->setComputer( computer );
+				m_master->computerManager().updateUser( controlInterface );
+			}
+			else
+			{
+				controlInterface = ComputerControlInterface::Pointer::create( computer );
+				startComputerControlInterface( controlInterface );
+			}
+
+			m_computerControlInterfaces[insertRow] = controlInterface;
 		}
 
-		++row;
+		endInsertRows();
+
+		firstChangedRow = qMin( firstChangedRow, row );
+		row += count;
+	}
+
+	for( const auto& controlInterface : qAsConst( movedComputerControlInterfaces ) )
+	{
+		stopComputerControlInterface( controlInterface );
+	}
+
+	updateUidRows( firstChangedRow );
+}
+
+
+
+QModelIndex ComputerControlListModel::computerIndex( NetworkObject::Uid uid ) const
+{
+	const auto row = m_uidRows.value( uid, -1 );
+	if( row < 0 )
+	{
+		return {};
+	}
+
+	return index( row );
+}
+
+
+
+void ComputerControlListModel::updateUidRows( int firstRow )
+{
+	// rows before firstRow are unchanged, so only the tail needs to be reindexed
+	for( int row = firstRow; row < m_computerControlInterfaces.count(); ++row )
+	{
+		m_uidRows[m_computerControlInterfaces[row]->computer().networkObjectUid()] = row;
 	}
 }
 
@@ -284,21 +405,63 @@ void ComputerControlListModel::update()
 
 void ComputerControlListModel::updateState( const QModelIndex& index )
 {
-	emit dataChanged( index, index, { Qt::DisplayRole, Qt::DecorationRole, Qt::ToolTipRole, ImageIdRole } );
+	if( index.isValid() == false )
+	{
+		return;
+	}
+
+	markChanged( index, { Qt::DisplayRole, Qt::DecorationRole, Qt::ToolTipRole, ImageIdRole } );
 }
 
 
 
 void ComputerControlListModel::updateScreen( const QModelIndex& index )
 {
-	emit dataChanged( index, index, { Qt::DecorationRole, ImageIdRole } );
+	if( index.isValid() == false )
+	{
+		return;
+	}
+
+	const auto& controlInterface = m_computerControlInterfaces[index.row()];
+
+	// scaledScreenUpdated() is also emitted when just the screen size changes which is handled by cachedScreen()
+	if( controlInterface->state() == ComputerControlInterface::State::Connected &&
+		controlInterface->scaledScreen().isNull() == false )
+	{
+		m_screenCache.updateScreen( controlInterface->computer().networkObjectUid() );
+	}
+
+	markChanged( index, { Qt::DecorationRole, ImageIdRole } );
+}
+
+
+
+void ComputerControlListModel::updateStaleScreen( NetworkObject::Uid uid )
+{
+	const auto index = computerIndex( uid );
+	if( index.isValid() == false )
+	{
+		return;
+	}
+
+	// change image ID so that views reload the image although there's no new live data
+	auto& cachedRoles = m_cachedRoles[uid];
+	++cachedRoles.staleScreenRevision;
+	cachedRoles.imageIdTimestamp = -1;
+
+	markChanged( index, { Qt::DecorationRole, ImageIdRole } );
 }
 
 
 
 void ComputerControlListModel::updateActiveFeatures( const QModelIndex& index )
 {
-	emit dataChanged( index, index, { Qt::ToolTipRole } );
+	if( index.isValid() == false )
+	{
+		return;
+	}
+
+	markChanged( index, { Qt::ToolTipRole } );
 	emit activeFeaturesChanged( index );
 }
 
@@ -306,9 +469,19 @@ void ComputerControlListModel::updateActiveFeatures( const QModelIndex& index )
 
 void ComputerControlListModel::updateUser( const QModelIndex& index )
 {
-	emit dataChanged( index, index, { Qt::DisplayRole, Qt::ToolTipRole } );
+	if( index.isValid() == false )
+	{
+		return;
+	}
 
 	auto controlInterface = computerControlInterface( index );
+	if( controlInterface.isNull() == false )
+	{
+		m_cachedRoles[controlInterface->computer().networkObjectUid()].sortKeyValid = false;
+	}
+
+	markChanged( index, { Qt::DisplayRole, Qt::ToolTipRole, Qt::InitialSortOrderRole } );
+
 	if( controlInterface.isNull() == false )
 	{
 		m_master->computerManager().updateUser( controlInterface );
@@ -317,9 +490,77 @@ void ComputerControlListModel::updateUser( const QModelIndex& index )
 
 
 
-void ComputerControlListModel::startComputerControlInterface( const ComputerControlInterface::Pointer& controlInterface,
-															  const QModelIndex& index )
+void ComputerControlListModel::markChanged( const QModelIndex& index, const QVector<int>& roles )
+{
+	auto& changedRoles = m_changedRoles[m_computerControlInterfaces[index.row()]->computer().networkObjectUid()];
+
+	for( auto role : roles )
+	{
+		if( changedRoles.contains( role ) == false )
+		{
+			changedRoles.append( role );
+		}
+	}
+
+	if( m_changesFlushTimer.isActive() == false )
+	{
+		m_changesFlushTimer.start();
+	}
+}
+
+
+
+void ComputerControlListModel::flushChanges()
+{
+	struct ChangedRow {
+		int row;
+		QVector<int> roles;
+	};
+
+	QVector<ChangedRow> changedRows;
+	changedRows.reserve( m_changedRoles.size() );
+
+	// changes are keyed by UID so they stay valid if rows are inserted or removed in the meantime
+	for( auto it = m_changedRoles.begin(), end = m_changedRoles.end(); it != end; ++it )
+	{
+		const auto row = m_uidRows.value( it.key(), -1 );
+		if( row >= 0 )
+		{
+			std::sort( it->begin(), it->end() );
+			changedRows.append( { row, *it } );
+		}
+	}
+
+	m_changedRoles.clear();
+
+	std::sort( changedRows.begin(), changedRows.end(),
+			   []( const ChangedRow& a, const ChangedRow& b ) { return a.row < b.row; } );
+
+	// merge adjacent rows with identical roles into one range
+	for( int first = 0; first < changedRows.count(); )
+	{
+		int last = first;
+		while( last + 1 < changedRows.count() &&
+			   changedRows[last+1].row == changedRows[last].row + 1 &&
+			   changedRows[last+1].roles == changedRows[first].roles )
+		{
+			++last;
+		}
+
+		emit dataChanged( index( changedRows[first].row ), index( changedRows[last].row ), changedRows[first].roles );
+
+		first = last + 1;
+	}
+}
+
+
+
+void ComputerControlListModel::startComputerControlInterface( const ComputerControlInterface::Pointer& controlInterface )
 {
+	// look up the row on each signal as rows shift when other computers are inserted or removed and
+	// the computer changes when the interface is reused for a host at another location
+	const auto computer = &controlInterface->computer();
+
 	controlInterface->start( computerScreenSize(), ComputerControlInterface::UpdateMode::Monitoring );
 
 	connect( controlInterface.data(), &ComputerControlInterface::featureMessageReceived, this,
@@ -328,16 +569,16 @@ void ComputerControlListModel::startComputerControlInterface( const ComputerCont
 	} );
 
 	connect( controlInterface.data(), &ComputerControlInterface::scaledScreenUpdated,
-			 this, [=] () { updateScreen( index ); } );
+			 this, [=] () { updateScreen( computerIndex( computer->networkObjectUid() ) ); } );
 
 	connect( controlInterface.data(), &ComputerControlInterface::activeFeaturesChanged,
-			 this, [=] () { updateActiveFeatures( index ); } );
+			 this, [=] () { updateActiveFeatures( computerIndex( computer->networkObjectUid() ) ); } );
 
 	connect( controlInterface.data(), &ComputerControlInterface::stateChanged,
-			 this, [=] () { updateState( index ); } );
+			 this, [=] () { updateState( computerIndex( computer->networkObjectUid() ) ); } );
 
 	connect( controlInterface.data(), &ComputerControlInterface::userChanged,
-			 this, [=]() { updateUser( index ); } );
+			 this, [=]() { updateUser( computerIndex( computer->networkObjectUid() ) ); } );
 }
 
 
@@ -383,33 +624,90 @@ QImage ComputerControlListModel::prepareIcon(const QImage &icon)
 
 
 
-QImage ComputerControlListModel::computerDecorationRole( const ComputerControlInterface::Pointer& controlInterface ) const
+const QImage& ComputerControlListModel::scaledIcon( const QImage& icon, QSize size ) const
 {
-	QImage image;
+	// all computers share the same screen size so only keep icons for the current one
+	if( size != m_scaledIconSize )
+	{
+		m_scaledIcons.clear();
+		m_scaledIconSize = size;
+	}
+
+	auto it = m_scaledIcons.find( icon.cacheKey() );
+	if( it == m_scaledIcons.end() )
+	{
+		it = m_scaledIcons.insert( icon.cacheKey(), icon.scaled( size, Qt::KeepAspectRatio ) );
+	}
+
+	return *it;
+}
+
+
+
+const QString& ComputerControlListModel::cachedSortKey( const ComputerControlInterface::Pointer& controlInterface ) const
+{
+	auto& cachedRoles = m_cachedRoles[controlInterface->computer().networkObjectUid()];
+
+	if( cachedRoles.sortKeyValid == false )
+	{
+		cachedRoles.sortKey = computerSortRole( controlInterface );
+		cachedRoles.sortKeyValid = true;
+	}
+
+	return cachedRoles.sortKey;
+}
 
+
+
+const QString& ComputerControlListModel::cachedImageId( const ComputerControlInterface::Pointer& controlInterface ) const
+{
+	auto& cachedRoles = m_cachedRoles[controlInterface->computer().networkObjectUid()];
+
+	if( cachedRoles.imageIdTimestamp != controlInterface->timestamp() )
+	{
+		cachedRoles.imageId = QStringLiteral("image://%1/%2/%3-%4").arg( imageProviderId(),
+																		 VeyonCore::formattedUuid( controlInterface->computer().networkObjectUid() ),
+																		 QString::number( controlInterface->timestamp() ),
+																		 QString::number( cachedRoles.staleScreenRevision ) );
+		cachedRoles.imageIdTimestamp = controlInterface->timestamp();
+	}
+
+	return cachedRoles.imageId;
+}
+
+
+
+QImage ComputerControlListModel::computerDecorationRole( const ComputerControlInterface::Pointer& controlInterface ) const
+{
 	switch( controlInterface->state() )
 	{
 	case ComputerControlInterface::State::Connected:
-		image = controlInterface->scaledScreen();
+	{
+		const auto image = controlInterface->scaledScreen();
 		if( image.isNull() == false )
 		{
 			return image;
 		}
-
-		image = m_iconDefault;
 		break;
+	}
 
 	case ComputerControlInterface::State::AuthenticationFailed:
 	case ComputerControlInterface::State::ServiceUnreachable:
-		image = m_iconConnectionProblem;
-		break;
+		return scaledIcon( m_iconConnectionProblem, controlInterface->scaledScreenSize() );
 
 	default:
-		image = m_iconDefault;
 		break;
 	}
 
-	return image.scaled( controlInterface->scaledScreenSize(), Qt::KeepAspectRatio );
+	// show the last known screen until live data arrives
+	const auto cachedScreen = m_screenCache.cachedScreen( controlInterface->computer().networkObjectUid(),
+														  controlInterface->scaledScreenSize() );
+	if( cachedScreen.isNull() == false )
+	{
+		return cachedScreen;
+	}
+
+	return scaledIcon( m_iconDefault, controlInterface->scaledScreenSize() );
 }
 
 
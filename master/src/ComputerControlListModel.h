@@ -27,9 +27,11 @@
 #include <QAbstractListModel>
 #include <QQuickImageProvider>
 #include <QImage>
+#include <QTimer>
 
 #include "ComputerListModel.h"
 #include "ComputerControlInterface.h"
+#include "ComputerScreenCache.h"
 
 class VeyonMaster;
 
@@ -70,18 +72,31 @@ signals:
 private:
 	void update();
 
+	QModelIndex computerIndex( NetworkObject::Uid uid ) const;
+	void updateUidRows( int firstRow = 0 );
+
 	void updateState( const QModelIndex& index );
 	void updateScreen( const QModelIndex& index );
+	void updateStaleScreen( NetworkObject::Uid uid );
 	void updateActiveFeatures( const QModelIndex& index );
 	void updateUser( const QModelIndex& index );
 
-	void startComputerControlInterface( const ComputerControlInterface::Pointer& controlInterface, const QModelIndex& index );
+	void markChanged( const QModelIndex& index, const QVector<int>& roles );
+	void flushChanges();
+
+	void startComputerControlInterface( const ComputerControlInterface::Pointer& controlInterface );
 	void stopComputerControlInterface( const ComputerControlInterface::Pointer& controlInterface );
 
 	QSize computerScreenSize() const;
 
+	// collect per-computer changes and emit them at most once per display frame
+	static constexpr int ChangesFlushInterval = 16;
+
 	void loadIcons();
 	QImage prepareIcon( const QImage& icon );
+	const QImage& scaledIcon( const QImage& icon, QSize size ) const;
+	const QString& cachedSortKey( const ComputerControlInterface::Pointer& controlInterface ) const;
+	const QString& cachedImageId( const ComputerControlInterface::Pointer& controlInterface ) const;
 	QImage computerDecorationRole( const ComputerControlInterface::Pointer& controlInterface ) const;
 	QString computerToolTipRole( const ComputerControlInterface::Pointer& controlInterface ) const;
 	QString computerDisplayRole( const ComputerControlInterface::Pointer& controlInterface ) const;
@@ -97,6 +112,26 @@ private:
 	QImage m_iconConnectionProblem;
 	QImage m_iconDemoMode;
 
+	mutable QSize m_scaledIconSize;
+	mutable QHash<qint64, QImage> m_scaledIcons;
+
+	// derived role data which is expensive to build and requested frequently, e.g. while sorting
+	struct CachedRoles {
+		QString sortKey;
+		bool sortKeyValid{false};
+		QString imageId;
+		int imageIdTimestamp{-1};
+		int staleScreenRevision{0};
+	};
+	mutable QHash<NetworkObject::Uid, CachedRoles> m_cachedRoles;
+
 	ComputerControlInterfaceList m_computerControlInterfaces;
+	QHash<NetworkObject::Uid, int> m_uidRows;
+
+	QHash<NetworkObject::Uid, QVector<int>> m_changedRoles;
+	QTimer m_changesFlushTimer;
+
+	// declared last so that pending screens can still be queried from the interfaces on destruction
+	mutable ComputerScreenCache m_screenCache;
 
 };
@@ -22,6 +22,8 @@
  *
  */
 
+#include <algorithm>
+
 #include <QCoreApplication>
 #include <QFile>
 #include <QHostAddress>
@@ -47,6 +49,7 @@ ComputerManager::ComputerManager( UserConfig& config, QObject* parent ) :
 	m_networkObjectOverlayDataModel( new NetworkObjectOverlayDataModel( tr( "User" ), this ) ),
 	m_computerTreeModel( new CheckableItemProxyModel( NetworkObjectModel::UidRole, this ) ),
 	m_networkObjectFilterProxyModel( new NetworkObjectFilterProxyModel( this ) ),
+	m_selectionChangedTimer( this ),
 	m_localHostNames( QHostInfo::localHostName().toLower() ),
 	m_localHostAddresses( QHostInfo::fromName( QHostInfo::localHostName() ).addresses() )
 {
@@ -68,6 +71,11 @@ ComputerManager::ComputerManager( UserConfig& config, QObject* parent ) :
 								 QHostInfo::localDomainName().toLower() );
 	}
 
+	// checking a location changes many items at once so notify once after the whole operation
+	m_selectionChangedTimer.setInterval( 0 );
+	m_selectionChangedTimer.setSingleShot( true );
+	connect( &m_selectionChangedTimer, &QTimer::timeout, this, &ComputerManager::computerSelectionChanged );
+
 	initNetworkObjectLayer();
 	initLocations();
 	initComputerTreeModel();
@@ -107,7 +115,7 @@ bool ComputerManager::saveComputerAndUsersList( const QString& fileName )
 {
 	QStringList lines( tr( "Computer name;Hostname;User" ) );
 
-	const auto computers = selectedComputers( QModelIndex() );
+	const auto computers = selectedComputers();
 
 	for( const auto& computer : computers )
 	{
@@ -139,15 +147,23 @@ bool ComputerManager::saveComputerAndUsersList( const QString& fileName )
 
 void ComputerManager::updateUser( const ComputerControlInterface::Pointer& controlInterface )
 {
-	const auto networkObjectIndex = findNetworkObject( controlInterface->computer().networkObjectUid() );
+	auto user = controlInterface->userFullName();
+	if( user.isEmpty() )
+	{
+		user = controlInterface->userLoginName();
+	}
+
+	updateUser( controlInterface->computer().networkObjectUid(), user );
+}
+
+
+
+void ComputerManager::updateUser( NetworkObject::Uid networkObjectUid, const QString& user )
+{
+	const auto networkObjectIndex = findNetworkObject( networkObjectUid );
 
 	if( networkObjectIndex.isValid() )
 	{
-		auto user = controlInterface->userFullName();
-		if( user.isEmpty() )
-		{
-			user = controlInterface->userLoginName();
-		}
 		m_networkObjectOverlayDataModel->setData( mapToUserNameModelIndex( networkObjectIndex ),
 												  user,
 												  Qt::DisplayRole );
@@ -158,17 +174,35 @@ void ComputerManager::updateUser( const ComputerControlInterface::Pointer& contr
 
 void ComputerManager::checkChangedData( const QModelIndex& topLeft, const QModelIndex& bottomRight, const QVector<int>& roles )
 {
-	Q_UNUSED(topLeft)
-	Q_UNUSED(bottomRight)
+	updateSelectedComputers( topLeft, bottomRight );
 
 	if( roles.contains( Qt::CheckStateRole ) )
 	{
-		emit computerSelectionChanged();
+		scheduleSelectionChanged();
 	}
 }
 
 
 
+void ComputerManager::scheduleSelectionChanged()
+{
+	if( m_selectionChangedTimer.isActive() == false )
+	{
+		m_selectionChangedTimer.start();
+	}
+}
+
+
+
+void ComputerManager::resetComputerSelection()
+{
+	resetSelectedComputers();
+
+	emit computerSelectionReset();
+}
+
+
+
 void ComputerManager::initLocations()
 {
 	for( const auto& hostName : qAsConst( m_localHostNames ) )
@@ -181,7 +215,7 @@ void ComputerManager::initLocations()
 		vDebug() << "initializing locations for host address" << address.toString();
 	}
 
-	m_currentLocations.append( findLocationOfComputer( m_localHostNames, m_localHostAddresses, QModelIndex() ) );
+	m_currentLocations.append( findLocationOfComputer( m_localHostNames, m_localHostAddresses ) );
 
 	vDebug() << "found locations" << m_currentLocations;
 
@@ -207,6 +241,7 @@ void ComputerManager::initLocations()
 void ComputerManager::initNetworkObjectLayer()
 {
 	m_networkObjectDirectory->update();
+	initNetworkObjectIndex();
 	m_networkObjectDirectory->setUpdateInterval( VeyonCore::config().networkObjectDirectoryUpdateInterval() );
 	m_networkObjectOverlayDataModel->setSourceModel( m_networkObjectModel );
 	m_networkObjectFilterProxyModel->setSourceModel( m_networkObjectOverlayDataModel );
@@ -259,17 +294,24 @@ void ComputerManager::initComputerTreeModel()
 
 	m_computerTreeModel->loadStates( checkedNetworkObjects );
 
+	resetSelectedComputers();
+
 	connect( computerTreeModel(), &QAbstractItemModel::modelReset,
-			 this, &ComputerManager::computerSelectionReset );
+			 this, &ComputerManager::resetComputerSelection );
 	connect( computerTreeModel(), &QAbstractItemModel::layoutChanged,
-			 this, &ComputerManager::computerSelectionReset );
+			 this, &ComputerManager::resetComputerSelection );
 
 	connect( computerTreeModel(), &QAbstractItemModel::dataChanged,
 			 this, &ComputerManager::checkChangedData );
 	connect( computerTreeModel(), &QAbstractItemModel::rowsInserted,
-			 this, &ComputerManager::computerSelectionChanged );
+			 this, [this]( const QModelIndex& parent, int first, int last ) {
+		addSelectedComputers( parent, first, last );
+		scheduleSelectionChanged();
+	} );
+	connect( computerTreeModel(), &QAbstractItemModel::rowsAboutToBeRemoved,
+			 this, &ComputerManager::removeSelectedComputers );
 	connect( computerTreeModel(), &QAbstractItemModel::rowsRemoved,
-			 this, &ComputerManager::computerSelectionChanged );
+			 this, &ComputerManager::scheduleSelectionChanged );
 }
 
 
@@ -284,35 +326,136 @@ void ComputerManager::updateLocationFilterList()
 
 
 
-QString ComputerManager::findLocationOfComputer( const QStringList& hostNames, const QList<QHostAddress>& hostAddresses, const QModelIndex& parent )
+void ComputerManager::initNetworkObjectIndex()
+{
+	connect( m_networkObjectModel, &QAbstractItemModel::rowsInserted,
+			 this, &ComputerManager::addToNetworkObjectIndex );
+	connect( m_networkObjectModel, &QAbstractItemModel::rowsAboutToBeRemoved,
+			 this, &ComputerManager::removeFromNetworkObjectIndex );
+	connect( m_networkObjectModel, &QAbstractItemModel::dataChanged,
+			 this, &ComputerManager::updateNetworkObjectIndex );
+	connect( m_networkObjectModel, &QAbstractItemModel::modelReset, this, [this]() {
+		m_computerIndex.clear();
+		m_hostAddressIndex.clear();
+		m_locationIndex.clear();
+		addToNetworkObjectIndex( QModelIndex(), 0, m_networkObjectModel->rowCount() - 1 );
+	} );
+
+	addToNetworkObjectIndex( QModelIndex(), 0, m_networkObjectModel->rowCount() - 1 );
+}
+
+
+
+void ComputerManager::addToNetworkObjectIndex( const QModelIndex& parent, int first, int last )
 {
 	QAbstractItemModel* model = networkObjectModel();
 
-	int rows = model->rowCount( parent );
+	const auto location = model->data( parent, NetworkObjectModel::NameRole ).toString();
 
-	for( int i = 0; i < rows; ++i )
+	for( int i = first; i <= last; ++i )
 	{
-		QModelIndex entryIndex = model->index( i, 0, parent );
+		const auto entryIndex = model->index( i, 0, parent );
 
-		auto objectType = static_cast<NetworkObject::Type>( model->data( entryIndex, NetworkObjectModel::TypeRole ).toInt() );
+		const auto objectType = static_cast<NetworkObject::Type>( model->data( entryIndex, NetworkObjectModel::TypeRole ).toInt() );
 
 		if( objectType == NetworkObject::Type::Location )
 		{
-			const auto location = findLocationOfComputer( hostNames, hostAddresses, entryIndex );
-			if( location.isEmpty() == false )
-			{
-				return location;
-			}
+			addToNetworkObjectIndex( entryIndex, 0, model->rowCount( entryIndex ) - 1 );
 		}
 		else if( objectType == NetworkObject::Type::Host )
 		{
-			QString currentHost = model->data( entryIndex, NetworkObjectModel::HostAddressRole ).toString().toLower();
-			QHostAddress currentHostAddress;
+			const auto uid = model->data( entryIndex, NetworkObjectModel::UidRole ).toUuid();
+			const auto hostAddress = hostAddressIndexKey( model->data( entryIndex, NetworkObjectModel::HostAddressRole ).toString() );
+
+			m_computerIndex[uid] = { entryIndex, hostAddress, location };
+			m_hostAddressIndex[hostAddress] = uid;
+			m_locationIndex.insert( location, uid );
+		}
+	}
+}
+
 
-			if( hostNames.contains( currentHost ) ||
-					( currentHostAddress.setAddress( currentHost ) && hostAddresses.contains( currentHostAddress ) ) )
+
+void ComputerManager::removeFromNetworkObjectIndex( const QModelIndex& parent, int first, int last )
+{
+	QAbstractItemModel* model = networkObjectModel();
+
+	for( int i = first; i <= last; ++i )
+	{
+		const auto entryIndex = model->index( i, 0, parent );
+
+		const auto objectType = static_cast<NetworkObject::Type>( model->data( entryIndex, NetworkObjectModel::TypeRole ).toInt() );
+
+		if( objectType == NetworkObject::Type::Location )
+		{
+			removeFromNetworkObjectIndex( entryIndex, 0, model->rowCount( entryIndex ) - 1 );
+		}
+		else if( objectType == NetworkObject::Type::Host )
+		{
+			const auto uid = model->data( entryIndex, NetworkObjectModel::UidRole ).toUuid();
+			const auto it = m_computerIndex.find( uid );
+			if( it != m_computerIndex.end() )
 			{
-				return model->data( parent, NetworkObjectModel::NameRole ).toString();
+				// remove by previously indexed values as the object data may already have changed
+				if( m_hostAddressIndex.value( it->hostAddress ) == uid )
+				{
+					m_hostAddressIndex.remove( it->hostAddress );
+				}
+				m_locationIndex.remove( it->location, uid );
+				m_computerIndex.erase( it );
+			}
+		}
+	}
+}
+
+
+
+void ComputerManager::updateNetworkObjectIndex( const QModelIndex& topLeft, const QModelIndex& bottomRight )
+{
+	removeFromNetworkObjectIndex( topLeft.parent(), topLeft.row(), bottomRight.row() );
+	addToNetworkObjectIndex( topLeft.parent(), topLeft.row(), bottomRight.row() );
+}
+
+
+
+QString ComputerManager::hostAddressIndexKey( const QString& hostAddress )
+{
+	// normalize IP addresses so that different notations of the same address match
+	QHostAddress address;
+	if( address.setAddress( hostAddress ) )
+	{
+		return address.toString();
+	}
+
+	return hostAddress.toLower();
+}
+
+
+
+QString ComputerManager::findLocationOfComputer( const QStringList& hostNames, const QList<QHostAddress>& hostAddresses )
+{
+	QStringList keys;
+	keys.reserve( hostNames.size() + hostAddresses.size() );
+
+	for( const auto& hostName : hostNames )
+	{
+		keys.append( hostAddressIndexKey( hostName ) );
+	}
+
+	for( const auto& hostAddress : hostAddresses )
+	{
+		keys.append( hostAddress.toString() );
+	}
+
+	for( const auto& key : qAsConst( keys ) )
+	{
+		const auto it = m_hostAddressIndex.constFind( key );
+		if( it != m_hostAddressIndex.constEnd() )
+		{
+			const auto location = m_computerIndex.value( *it ).location;
+			if( location.isEmpty() == false )
+			{
+				return location;
 			}
 		}
 	}
@@ -322,50 +465,195 @@ QString ComputerManager::findLocationOfComputer( const QStringList& hostNames, c
 
 
 
-ComputerList ComputerManager::getComputersAtLocation( const QString& locationName, const QModelIndex& parent )
+ComputerList ComputerManager::getComputersAtLocation( const QString& locationName )
 {
-	QAbstractItemModel* model = computerTreeModel();
+	QAbstractItemModel* model = networkObjectModel();
+
+	ComputerList computers;
+
+	for( auto it = m_locationIndex.constFind( locationName ); it != m_locationIndex.constEnd() && it.key() == locationName; ++it )
+	{
+		const auto entryIndex = QModelIndex( m_computerIndex.value( *it ).index );
+
+		computers += Computer( *it,
+							   model->data( entryIndex, NetworkObjectModel::NameRole ).toString(),
+							   model->data( entryIndex, NetworkObjectModel::HostAddressRole ).toString(),
+							   model->data( entryIndex, NetworkObjectModel::MacAddressRole ).toString() );
+	}
+
+	return computers;
+}
 
-	int rows = model->rowCount( parent );
+
+
+ComputerList ComputerManager::selectedComputers() const
+{
+	// order computers by their position in the computer tree so the result matches a full walk
+	QVector<QPair<QVector<int>, const Computer*>> sortedComputers;
+	sortedComputers.reserve( m_selectedComputers.size() );
+
+	for( const auto& selectedComputer : m_selectedComputers )
+	{
+		sortedComputers.append( { treePosition( selectedComputer.index ), &selectedComputer.computer } );
+	}
+
+	std::sort( sortedComputers.begin(), sortedComputers.end(),
+			   []( const QPair<QVector<int>, const Computer*>& a, const QPair<QVector<int>, const Computer*>& b ) {
+		return a.first < b.first;
+	} );
 
 	ComputerList computers;
+	computers.reserve( sortedComputers.size() );
 
-	for( int i = 0; i < rows; ++i )
+	for( const auto& sortedComputer : qAsConst( sortedComputers ) )
 	{
-		QModelIndex entryIndex = model->index( i, 0, parent );
+		computers.append( *sortedComputer.second );
+	}
 
-		auto objectType = static_cast<NetworkObject::Type>( model->data( entryIndex, NetworkObjectModel::TypeRole ).toInt() );
+#ifdef VEYON_DEBUG
+	// verify incrementally maintained selection against a full walk of the computer tree
+	const auto expectedComputers = findSelectedComputers( QModelIndex() );
+	if( computers.size() != expectedComputers.size() ||
+		std::equal( computers.cbegin(), computers.cend(), expectedComputers.cbegin() ) == false )
+	{
+		vCritical() << "inconsistent computer selection:" << computers.size() << "computers instead of"
+					<< expectedComputers.size();
+	}
+#endif
 
-		switch( objectType )
+	return computers;
+}
+
+
+
+void ComputerManager::resetSelectedComputers()
+{
+	m_selectedComputers.clear();
+
+	const auto computerIndexes = findSelectedComputerIndexes( QModelIndex() );
+	for( const auto& computerIndex : computerIndexes )
+	{
+		insertSelectedComputer( computerIndex );
+	}
+}
+
+
+
+void ComputerManager::addSelectedComputers( const QModelIndex& parent, int first, int last )
+{
+	QAbstractItemModel* model = computerTreeModel();
+
+	for( int i = first; i <= last; ++i )
+	{
+		const auto entryIndex = model->index( i, 0, parent );
+
+		if( model->data( entryIndex, NetworkObjectModel::CheckStateRole ).value<Qt::CheckState>() == Qt::Unchecked )
 		{
-		case NetworkObject::Type::Location:
-			if( model->data( entryIndex, NetworkObjectModel::NameRole ).toString() == locationName )
+			continue;
+		}
+
+		const auto objectType = static_cast<NetworkObject::Type>( model->data( entryIndex, NetworkObjectModel::TypeRole ).toInt() );
+
+		if( objectType == NetworkObject::Type::Location )
+		{
+			const auto computerIndexes = findSelectedComputerIndexes( entryIndex );
+			for( const auto& computerIndex : computerIndexes )
 			{
-				computers += getComputersAtLocation( locationName, entryIndex );
+				insertSelectedComputer( computerIndex );
 			}
-			break;
-		case NetworkObject::Type::Host:
-			computers += Computer( model->data( entryIndex, NetworkObjectModel::UidRole ).toUuid(),
-								   model->data( entryIndex, NetworkObjectModel::NameRole ).toString(),
-								   model->data( entryIndex, NetworkObjectModel::HostAddressRole ).toString(),
-								   model->data( entryIndex, NetworkObjectModel::MacAddressRole ).toString() );
-			break;
-		default: break;
+		}
+		else if( objectType == NetworkObject::Type::Host )
+		{
+			insertSelectedComputer( entryIndex );
 		}
 	}
+}
 
-	return computers;
+
+
+void ComputerManager::removeSelectedComputers( const QModelIndex& parent, int first, int last )
+{
+	QAbstractItemModel* model = computerTreeModel();
+
+	for( int i = first; i <= last; ++i )
+	{
+		const auto entryIndex = model->index( i, 0, parent );
+
+		const auto objectType = static_cast<NetworkObject::Type>( model->data( entryIndex, NetworkObjectModel::TypeRole ).toInt() );
+
+		if( objectType == NetworkObject::Type::Location )
+		{
+			removeSelectedComputers( entryIndex, 0, model->rowCount( entryIndex ) - 1 );
+		}
+		else if( objectType == NetworkObject::Type::Host )
+		{
+			m_selectedComputers.remove( model->data( entryIndex, NetworkObjectModel::UidRole ).toUuid() );
+		}
+	}
 }
 
 
 
-ComputerList ComputerManager::selectedComputers( const QModelIndex& parent )
+void ComputerManager::updateSelectedComputers( const QModelIndex& topLeft, const QModelIndex& bottomRight )
 {
 	QAbstractItemModel* model = computerTreeModel();
 
+	const auto parent = topLeft.parent();
+
+	// check state changes of locations are propagated to their children which report their own changes
+	for( int i = topLeft.row(); i <= bottomRight.row(); ++i )
+	{
+		const auto entryIndex = model->index( i, 0, parent );
+
+		if( static_cast<NetworkObject::Type>( model->data( entryIndex, NetworkObjectModel::TypeRole ).toInt() ) !=
+				NetworkObject::Type::Host )
+		{
+			continue;
+		}
+
+		if( model->data( entryIndex, NetworkObjectModel::CheckStateRole ).value<Qt::CheckState>() == Qt::Unchecked )
+		{
+			m_selectedComputers.remove( model->data( entryIndex, NetworkObjectModel::UidRole ).toUuid() );
+		}
+		else
+		{
+			insertSelectedComputer( entryIndex );
+		}
+	}
+}
+
+
+
+void ComputerManager::insertSelectedComputer( const QModelIndex& index )
+{
+	const auto computer = computerFromIndex( index );
+
+	m_selectedComputers[computer.networkObjectUid()] = { index, computer };
+}
+
+
+
+QVector<int> ComputerManager::treePosition( const QModelIndex& index )
+{
+	QVector<int> position;
+
+	for( auto i = index; i.isValid(); i = i.parent() )
+	{
+		position.prepend( i.row() );
+	}
+
+	return position;
+}
+
+
+
+QModelIndexList ComputerManager::findSelectedComputerIndexes( const QModelIndex& parent ) const
+{
+	const auto model = m_computerTreeModel;
+
 	int rows = model->rowCount( parent );
 
-	ComputerList computers;
+	QModelIndexList computerIndexes;
 
 	for( int i = 0; i < rows; ++i )
 	{
@@ -381,51 +669,56 @@ ComputerList ComputerManager::selectedComputers( const QModelIndex& parent )
 		switch( objectType )
 		{
 		case NetworkObject::Type::Location:
-			computers += selectedComputers( entryIndex );
+			computerIndexes += findSelectedComputerIndexes( entryIndex );
 			break;
 		case NetworkObject::Type::Host:
-			computers += Computer( model->data( entryIndex, NetworkObjectModel::UidRole ).toUuid(),
-								   model->data( entryIndex, NetworkObjectModel::NameRole ).toString(),
-								   model->data( entryIndex, NetworkObjectModel::HostAddressRole ).toString(),
-								   model->data( entryIndex, NetworkObjectModel::MacAddressRole ).toString(),
-								   model->data( parent, NetworkObjectModel::NameRole ).toString() );
+			computerIndexes += entryIndex;
 			break;
 		default: break;
 		}
 	}
 
-	return computers;
+	return computerIndexes;
 }
 
 
 
-QModelIndex ComputerManager::findNetworkObject( NetworkObject::Uid networkObjectUid, const QModelIndex& parent )
+ComputerList ComputerManager::findSelectedComputers( const QModelIndex& parent ) const
 {
-	QAbstractItemModel* model = networkObjectModel();
+	const auto computerIndexes = findSelectedComputerIndexes( parent );
 
-	int rows = model->rowCount( parent );
+	ComputerList computers;
+	computers.reserve( computerIndexes.size() );
 
-	for( int i = 0; i < rows; ++i )
+	for( const auto& computerIndex : computerIndexes )
 	{
-		QModelIndex entryIndex = model->index( i, 0, parent );
+		computers.append( computerFromIndex( computerIndex ) );
+	}
 
-		auto objectType = static_cast<NetworkObject::Type>( model->data( entryIndex, NetworkObjectModel::TypeRole ).toInt() );
+	return computers;
+}
 
-		if( objectType == NetworkObject::Type::Location )
-		{
-			QModelIndex index = findNetworkObject( networkObjectUid, entryIndex );
-			if( index.isValid() )
-			{
-				return index;
-			}
-		}
-		else if( objectType == NetworkObject::Type::Host )
-		{
-			if( model->data( entryIndex, NetworkObjectModel::UidRole ).toUuid() == networkObjectUid )
-			{
-				return entryIndex;
-			}
-		}
+
+
+Computer ComputerManager::computerFromIndex( const QModelIndex& index ) const
+{
+	const auto model = m_computerTreeModel;
+
+	return Computer( model->data( index, NetworkObjectModel::UidRole ).toUuid(),
+					 model->data( index, NetworkObjectModel::NameRole ).toString(),
+					 model->data( index, NetworkObjectModel::HostAddressRole ).toString(),
+					 model->data( index, NetworkObjectModel::MacAddressRole ).toString(),
+					 model->data( index.parent(), NetworkObjectModel::NameRole ).toString() );
+}
+
+
+
+QModelIndex ComputerManager::findNetworkObject( NetworkObject::Uid networkObjectUid )
+{
+	const auto it = m_computerIndex.constFind( networkObjectUid );
+	if( it != m_computerIndex.constEnd() )
+	{
+		return it->index;
 	}
 
 	return {};
@@ -24,6 +24,9 @@
 
 #pragma once
 
+#include <QHash>
+#include <QTimer>
+
 #include "CheckableItemProxyModel.h"
 #include "ComputerControlInterface.h"
 
@@ -50,7 +53,7 @@ public:
 		return m_computerTreeModel;
 	}
 
-	ComputerList selectedComputers( const QModelIndex& parent );
+	ComputerList selectedComputers() const;
 
 	void addLocation( const QString& location );
 	void removeLocation( const QString& location );
@@ -58,6 +61,7 @@ public:
 	bool saveComputerAndUsersList( const QString& fileName );
 
 	void updateUser( const ComputerControlInterface::Pointer& controlInterface );
+	void updateUser( NetworkObject::Uid networkObjectUid, const QString& user );
 
 signals:
 	void computerSelectionReset();
@@ -65,17 +69,36 @@ signals:
 
 private:
 	void checkChangedData( const QModelIndex& topLeft, const QModelIndex& bottomRight, const QVector<int>& roles );
+	void scheduleSelectionChanged();
+	void resetComputerSelection();
+
+	void resetSelectedComputers();
+	void addSelectedComputers( const QModelIndex& parent, int first, int last );
+	void removeSelectedComputers( const QModelIndex& parent, int first, int last );
+	void updateSelectedComputers( const QModelIndex& topLeft, const QModelIndex& bottomRight );
+	void insertSelectedComputer( const QModelIndex& index );
+	static QVector<int> treePosition( const QModelIndex& index );
+
+	QModelIndexList findSelectedComputerIndexes( const QModelIndex& parent ) const;
+	ComputerList findSelectedComputers( const QModelIndex& parent ) const;
+	Computer computerFromIndex( const QModelIndex& index ) const;
 
 	void initLocations();
 	void initNetworkObjectLayer();
 	void initComputerTreeModel();
 	void updateLocationFilterList();
 
-	QString findLocationOfComputer( const QStringList& hostNames, const QList<QHostAddress>& hostAddresses, const QModelIndex& parent );
+	void initNetworkObjectIndex();
+	void addToNetworkObjectIndex( const QModelIndex& parent, int first, int last );
+	void removeFromNetworkObjectIndex( const QModelIndex& parent, int first, int last );
+	void updateNetworkObjectIndex( const QModelIndex& topLeft, const QModelIndex& bottomRight );
+	static QString hostAddressIndexKey( const QString& hostAddress );
 
-	ComputerList getComputersAtLocation( const QString& locationName, const QModelIndex& parent = QModelIndex() );
+	QString findLocationOfComputer( const QStringList& hostNames, const QList<QHostAddress>& hostAddresses );
 
-	QModelIndex findNetworkObject( NetworkObject::Uid networkObjectUid, const QModelIndex& parent = QModelIndex() );
+	ComputerList getComputersAtLocation( const QString& locationName );
+
+	QModelIndex findNetworkObject( NetworkObject::Uid networkObjectUid );
 
 	QModelIndex mapToUserNameModelIndex( const QModelIndex& networkObjectIndex );
 
@@ -89,6 +112,25 @@ private:
 	CheckableItemProxyModel* m_computerTreeModel;
 	NetworkObjectFilterProxyModel* m_networkObjectFilterProxyModel;
 
+	QTimer m_selectionChangedTimer;
+
+	// computers of m_networkObjectModel indexed by UID, host address and location name
+	struct ComputerIndexEntry {
+		QPersistentModelIndex index;
+		QString hostAddress;
+		QString location;
+	};
+	QHash<NetworkObject::Uid, ComputerIndexEntry> m_computerIndex;
+	QHash<QString, NetworkObject::Uid> m_hostAddressIndex;
+	QMultiHash<QString, NetworkObject::Uid> m_locationIndex;
+
+	// selected computers indexed by UID along with their position in the computer tree model
+	struct SelectedComputer {
+		QPersistentModelIndex index;
+		Computer computer;
+	};
+	QHash<NetworkObject::Uid, SelectedComputer> m_selectedComputers;
+
 	QStringList m_currentLocations;
 	QStringList m_locationFilterList;
 
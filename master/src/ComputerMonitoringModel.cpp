@@ -31,12 +31,47 @@
 
 
 ComputerMonitoringModel::ComputerMonitoringModel( ComputerControlListModel* sourceModel, QObject* parent ) :
-	QSortFilterProxyModel( parent )
+	QSortFilterProxyModel( parent ),
+	m_searchFilterTimer( this )
 {
 #if defined(QT_TESTLIB_LIB) && QT_VERSION >= QT_VERSION_CHECK(5, 11, 0)
 	new QAbstractItemModelTester( this, QAbstractItemModelTester::FailureReportingMode::Warning, this );
 #endif
 
+	// re-filter once typing paused
+	m_searchFilterTimer.setInterval( SearchFilterDelay );
+	m_searchFilterTimer.setSingleShot( true );
+	connect( &m_searchFilterTimer, &QTimer::timeout, this, &ComputerMonitoringModel::applySearchFilter );
+
+	// keep cached filter data in sync with the source model - connected before setSourceModel() so that
+	// it is updated before QSortFilterProxyModel re-filters changed rows
+	connect( sourceModel, &QAbstractItemModel::dataChanged, this,
+			 [this]( const QModelIndex& topLeft, const QModelIndex& bottomRight, const QVector<int>& roles ) {
+		if( roles.isEmpty() || roles.contains( Qt::DisplayRole ) || roles.contains( m_groupsRole ) )
+		{
+			invalidateFilterData( topLeft.row(), bottomRight.row() );
+		}
+	} );
+	connect( sourceModel, &QAbstractItemModel::rowsInserted, this,
+			 [this]( const QModelIndex& parent, int first, int last ) {
+		Q_UNUSED(parent)
+		if( first <= m_filterData.count() )
+		{
+			m_filterData.insert( first, last - first + 1, {} );
+		}
+	} );
+	connect( sourceModel, &QAbstractItemModel::rowsRemoved, this,
+			 [this]( const QModelIndex& parent, int first, int last ) {
+		Q_UNUSED(parent)
+		if( first < m_filterData.count() )
+		{
+			m_filterData.remove( first, qMin( last, m_filterData.count() - 1 ) - first + 1 );
+		}
+	} );
+	connect( sourceModel, &QAbstractItemModel::rowsMoved, this, [this]() { m_filterData.clear(); } );
+	connect( sourceModel, &QAbstractItemModel::layoutChanged, this, [this]() { m_filterData.clear(); } );
+	connect( sourceModel, &QAbstractItemModel::modelReset, this, [this]() { m_filterData.clear(); } );
+
 	setSourceModel( sourceModel );
 	setFilterCaseSensitivity( Qt::CaseInsensitive );
 	setSortRole( Qt::InitialSortOrderRole );
@@ -60,6 +95,7 @@ void ComputerMonitoringModel::setGroupsRole( int role )
 {
 	beginResetModel();
 	m_groupsRole = role;
+	m_filterData.clear();
 	endResetModel();
 }
 
@@ -77,12 +113,38 @@ void ComputerMonitoringModel::setStateFilter( ComputerControlInterface::State st
 void ComputerMonitoringModel::setGroupsFilter( const QStringList& groups )
 {
 	beginResetModel();
+
 	m_groupsFilter = groups.toSet();
+	m_groupsFilterMask = 0;
+	m_groupsFilterOverflow = false;
+
+	for( const auto& group : qAsConst( m_groupsFilter ) )
+	{
+		const auto bit = groupBit( group );
+		if( bit < 0 )
+		{
+			m_groupsFilterOverflow = true;
+		}
+		else
+		{
+			m_groupsFilterMask |= quint64(1) << bit;
+		}
+	}
+
 	endResetModel();
 }
 
 
 
+void ComputerMonitoringModel::setSearchFilter( const QString& searchFilter )
+{
+	m_searchFilter = searchFilter;
+
+	m_searchFilterTimer.start();
+}
+
+
+
 bool ComputerMonitoringModel::filterAcceptsRow( int sourceRow, const QModelIndex& sourceParent ) const
 {
 	if( m_stateFilter != ComputerControlInterface::State::None &&
@@ -93,13 +155,111 @@ bool ComputerMonitoringModel::filterAcceptsRow( int sourceRow, const QModelIndex
 		return false;
 	}
 
-	if( m_groupsRole >= 0 &&
-		groupsFilter().isEmpty() == false &&
-		sourceModel()->data( sourceModel()->index( sourceRow, 0, sourceParent ),
-							 m_groupsRole ).toStringList().toSet().intersects( groupsFilter() ) == false )
+	const auto groupsFiltered = m_groupsRole >= 0 && groupsFilter().isEmpty() == false;
+
+	if( groupsFiltered == false && m_normalizedSearchFilter.isEmpty() )
 	{
-		return false;
+		return true;
+	}
+
+	const auto& data = filterData( sourceRow );
+
+	if( groupsFiltered && ( data.groups & m_groupsFilterMask ) == 0 )
+	{
+		// groups without a bit can only match if both the row and the filter have such groups
+		if( data.groupsOverflow == false || m_groupsFilterOverflow == false ||
+			sourceModel()->data( sourceModel()->index( sourceRow, 0, sourceParent ),
+								 m_groupsRole ).toStringList().toSet().intersects( groupsFilter() ) == false )
+		{
+			return false;
+		}
+	}
+
+	return m_normalizedSearchFilter.isEmpty() || data.text.contains( m_normalizedSearchFilter );
+}
+
+
+
+const ComputerMonitoringModel::FilterData& ComputerMonitoringModel::filterData( int sourceRow ) const
+{
+	if( sourceRow >= m_filterData.count() )
+	{
+		m_filterData.resize( qMax( sourceRow + 1, sourceModel()->rowCount() ) );
+	}
+
+	auto& data = m_filterData[sourceRow];
+
+	if( data.valid == false )
+	{
+		const auto index = sourceModel()->index( sourceRow, 0 );
+
+		data.text = sourceModel()->data( index, Qt::DisplayRole ).toString().toLower();
+		data.groups = 0;
+		data.groupsOverflow = false;
+
+		if( m_groupsRole >= 0 )
+		{
+			const auto groups = sourceModel()->data( index, m_groupsRole ).toStringList();
+			for( const auto& group : groups )
+			{
+				const auto bit = groupBit( group );
+				if( bit < 0 )
+				{
+					data.groupsOverflow = true;
+				}
+				else
+				{
+					data.groups |= quint64(1) << bit;
+				}
+			}
+		}
+
+		data.valid = true;
+	}
+
+	return data;
+}
+
+
+
+int ComputerMonitoringModel::groupBit( const QString& group ) const
+{
+	const auto it = m_groupBits.constFind( group );
+	if( it != m_groupBits.constEnd() )
+	{
+		return *it;
 	}
 
-	return QSortFilterProxyModel::filterAcceptsRow( sourceRow, sourceParent );
+	if( m_groupBits.count() >= MaxGroupBits )
+	{
+		return -1;
+	}
+
+	const auto bit = m_groupBits.count();
+	m_groupBits.insert( group, bit );
+
+	return bit;
+}
+
+
+
+void ComputerMonitoringModel::invalidateFilterData( int first, int last )
+{
+	for( int row = first; row <= last && row < m_filterData.count(); ++row )
+	{
+		m_filterData[row].valid = false;
+	}
+}
+
+
+
+void ComputerMonitoringModel::applySearchFilter()
+{
+	const auto normalizedSearchFilter = m_searchFilter.toLower();
+
+	if( normalizedSearchFilter != m_normalizedSearchFilter )
+	{
+		m_normalizedSearchFilter = normalizedSearchFilter;
+		invalidateFilter();
+	}
 }
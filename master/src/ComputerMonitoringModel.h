@@ -25,6 +25,7 @@
 #pragma once
 
 #include <QSortFilterProxyModel>
+#include <QTimer>
 
 #include "ComputerControlInterface.h"
 
@@ -64,13 +65,44 @@ public:
 
 	void setGroupsFilter( const QStringList& groups );
 
+	const QString& searchFilter() const
+	{
+		return m_searchFilter;
+	}
+
+	void setSearchFilter( const QString& searchFilter );
+
 protected:
 	bool filterAcceptsRow( int sourceRow, const QModelIndex& sourceParent ) const override;
 
 private:
+	// normalized attributes of a source row so that filtering does not have to query and convert role data
+	struct FilterData {
+		QString text;
+		quint64 groups{0};
+		bool groupsOverflow{false};
+		bool valid{false};
+	};
+
+	static constexpr int MaxGroupBits = 64;
+	static constexpr int SearchFilterDelay = 200;
+
+	const FilterData& filterData( int sourceRow ) const;
+	int groupBit( const QString& group ) const;
+	void invalidateFilterData( int first, int last );
+	void applySearchFilter();
+
 	int m_stateRole{-1};
 	int m_groupsRole{-1};
 	ComputerControlInterface::State m_stateFilter{ComputerControlInterface::State::None};
 	QSet<QString> m_groupsFilter;
+	quint64 m_groupsFilterMask{0};
+	bool m_groupsFilterOverflow{false};
+	QString m_searchFilter;
+	QString m_normalizedSearchFilter;
+	QTimer m_searchFilterTimer;
+
+	mutable QVector<FilterData> m_filterData;
+	mutable QHash<QString, int> m_groupBits;
 
 };
@@ -63,14 +63,14 @@ void ComputerMonitoringView::saveConfiguration()
 
 QString ComputerMonitoringView::searchFilter() const
 {
-	return listModel()->filterRegExp().pattern();
+	return listModel()->searchFilter();
 }
 
 
 
 void ComputerMonitoringView::setSearchFilter( const QString& searchFilter )
 {
-	listModel()->setFilterRegExp( searchFilter );
+	listModel()->setSearchFilter( searchFilter );
 }
 
 
@@ -124,6 +124,38 @@ int ComputerMonitoringView::computerScreenSize() const
 
 
 
+int ComputerMonitoringView::optimalComputerScreenSize( QSize viewportSize, int itemCount, int spacing, QSize decorationSize )
+{
+	if( itemCount <= 0 )
+	{
+		return MaximumComputerScreenSize;
+	}
+
+	// items are laid out in a grid with spacing around each item - for every possible number of
+	// columns determine the largest screen width which fits horizontally and vertically
+	int bestSize = MinimumComputerScreenSize;
+
+	for( int columns = 1; columns <= itemCount; ++columns )
+	{
+		const auto rows = ( itemCount + columns - 1 ) / columns;
+
+		const auto maxWidth = ( viewportSize.width() - spacing ) / columns - spacing - decorationSize.width();
+		const auto maxHeight = ( viewportSize.height() - spacing ) / rows - spacing - decorationSize.height();
+
+		// screens have an aspect ratio of 16:9
+		bestSize = qMax( bestSize, qMin( maxWidth, maxHeight * 16 / 9 ) );
+
+		if( maxWidth <= MinimumComputerScreenSize )
+		{
+			break;
+		}
+	}
+
+	return qBound<int>( MinimumComputerScreenSize, bestSize, MaximumComputerScreenSize );
+}
+
+
+
 void ComputerMonitoringView::runFeature( const Feature& feature )
 {
 	auto computerControlInterfaces = selectedComputerControlInterfaces();
@@ -57,6 +57,8 @@ public:
 	void setComputerScreenSize( int size );
 	int computerScreenSize() const;
 
+	static int optimalComputerScreenSize( QSize viewportSize, int itemCount, int spacing, QSize decorationSize );
+
 	virtual void alignComputers() = 0;
 
 protected:
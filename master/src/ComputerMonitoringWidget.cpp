@@ -22,9 +22,7 @@
  *
  */
 
-#include <QApplication>
 #include <QMenu>
-#include <QScrollBar>
 #include <QShowEvent>
 #include <QTimer>
 
@@ -88,35 +86,20 @@ ComputerControlInterfaceList ComputerMonitoringWidget::selectedComputerControlIn
 
 void ComputerMonitoringWidget::autoAdjustComputerScreenSize()
 {
-	int size = iconSize().width();
-
-	if( verticalScrollBar()->isVisible() ||
-		horizontalScrollBar()->isVisible() )
+	const auto itemCount = model() ? model()->rowCount() : 0;
+	if( itemCount <= 0 )
 	{
-		while( ( verticalScrollBar()->isVisible() ||
-				 horizontalScrollBar()->isVisible() ) &&
-			   size > MinimumComputerScreenSize )
-		{
-			size -= 10;
-			setComputerScreenSize( size );
-			QApplication::processEvents();
-		}
+		return;
 	}
-	else
-	{
-		while( verticalScrollBar()->isVisible() == false &&
-			   horizontalScrollBar()->isVisible() == false &&
-			   size < MaximumComputerScreenSize )
-		{
-			size += 10;
-			setComputerScreenSize( size );
-			QApplication::processEvents();
-		}
 
-		setComputerScreenSize( size-20 );
-	}
+	// space taken by label and margins of an item in addition to its icon
+	const auto itemSize = sizeHintForIndex( model()->index( 0, 0 ) );
+	const QSize decorationSize( qMax( 0, itemSize.width() - iconSize().width() ),
+								qMax( 0, itemSize.height() - iconSize().height() ) );
+
+	setComputerScreenSize( optimalComputerScreenSize( maximumViewportSize(), itemCount, spacing(), decorationSize ) );
 
-	emit computerScreenSizeAdjusted( size );
+	emit computerScreenSizeAdjusted( computerScreenSize() );
 }
 
 
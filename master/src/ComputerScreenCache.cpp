@@ -0,0 +1,303 @@
+/*
+ * ComputerScreenCache.cpp - implementation of ComputerScreenCache class
+ *
+ * Copyright (c) 2019 Tobias Junghans <tobydox@veyon.io>
+ *
+ * This file is part of Veyon - https://veyon.io
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program (see COPYING); if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ *
+ */
+
+#include <cstring>
+
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
+#include <QPainter>
+#include <QSaveFile>
+#include <QSemaphore>
+#include <QStandardPaths>
+
+#include "ComputerMonitoringView.h"
+#include "ComputerScreenCache.h"
+#include "VeyonCore.h"
+
+
+ComputerScreenCache::ComputerScreenCache( const ScreenProvider& screenProvider, QObject* parent ) :
+	QObject( parent ),
+	m_screenProvider( screenProvider ),
+	m_directory( QStandardPaths::writableLocation( QStandardPaths::CacheLocation ) + QStringLiteral("/screens") ),
+	m_updatedScreens(),
+	m_staleScreens(),
+	m_flushTimer( this ),
+	m_writerThread( this ),
+	m_writerContext( new QObject )
+{
+	m_flushTimer.setInterval( FlushInterval );
+	m_flushTimer.setSingleShot( true );
+	connect( &m_flushTimer, &QTimer::timeout, this, &ComputerScreenCache::flush );
+
+	// screens are loaded in the writer thread
+	connect( this, &ComputerScreenCache::staleScreenLoaded, this, &ComputerScreenCache::insertStaleScreen,
+			 Qt::QueuedConnection );
+
+	m_writerContext->moveToThread( &m_writerThread );
+	m_writerThread.start( QThread::LowPriority );
+
+	const auto directory = m_directory;
+	QTimer::singleShot( 0, m_writerContext, [directory]() { removeExpiredScreens( directory ); } );
+}
+
+
+
+ComputerScreenCache::~ComputerScreenCache()
+{
+	// let the writer thread process all screens queued so far as quitting would discard them
+	QSemaphore drained;
+	QTimer::singleShot( 0, m_writerContext, [&drained]() { drained.release(); } );
+	drained.acquire();
+
+	m_writerThread.quit();
+	m_writerThread.wait();
+
+	delete m_writerContext;
+
+	// write screens updated since the last flush synchronously as the writer thread is gone
+	writeScreens( m_directory, takeUpdatedScreens() );
+}
+
+
+
+QImage ComputerScreenCache::cachedScreen( NetworkObject::Uid uid, QSize size )
+{
+	const auto it = m_staleScreens.constFind( uid );
+	if( it != m_staleScreens.constEnd() && it->size == size )
+	{
+		return it->image;
+	}
+
+	// remember pending and missing screens so that the file is not looked up again
+	m_staleScreens.insert( uid, { size, {} } );
+
+	// do not block the GUI thread with file accesses and announce the screen once it is available
+	const auto directory = m_directory;
+	QTimer::singleShot( 0, m_writerContext, [this, directory, uid, size]() {
+		emit staleScreenLoaded( uid, size, loadScreen( directory, uid, size ) );
+	} );
+
+	return {};
+}
+
+
+
+void ComputerScreenCache::updateScreen( NetworkObject::Uid uid )
+{
+	m_updatedScreens.insert( uid );
+	m_staleScreens.remove( uid );
+
+	if( m_flushTimer.isActive() == false )
+	{
+		m_flushTimer.start();
+	}
+}
+
+
+
+void ComputerScreenCache::removeScreen( NetworkObject::Uid uid )
+{
+	m_staleScreens.remove( uid );
+
+	// the screen can't be fetched anymore once the computer is gone so write it right now
+	if( m_updatedScreens.remove( uid ) )
+	{
+		Screens screens;
+		const auto screen = m_screenProvider( uid );
+		if( screen.isNull() == false )
+		{
+			screens[uid] = screen;
+		}
+		writeScreensInBackground( screens );
+	}
+}
+
+
+
+void ComputerScreenCache::clear()
+{
+	flush();
+
+	m_staleScreens.clear();
+}
+
+
+
+void ComputerScreenCache::flush()
+{
+	m_flushTimer.stop();
+
+	writeScreensInBackground( takeUpdatedScreens() );
+}
+
+
+
+ComputerScreenCache::Screens ComputerScreenCache::takeUpdatedScreens()
+{
+	Screens screens;
+	screens.reserve( m_updatedScreens.size() );
+
+	for( const auto& uid : qAsConst( m_updatedScreens ) )
+	{
+		const auto screen = m_screenProvider( uid );
+		if( screen.isNull() == false )
+		{
+			screens[uid] = screen;
+		}
+	}
+
+	m_updatedScreens.clear();
+
+	return screens;
+}
+
+
+
+void ComputerScreenCache::writeScreensInBackground( const Screens& screens )
+{
+	if( screens.isEmpty() == false )
+	{
+		// images are implicitly shared so handing them over to the writer thread does not copy any pixels
+		const auto directory = m_directory;
+		QTimer::singleShot( 0, m_writerContext, [directory, screens]() { writeScreens( directory, screens ); } );
+	}
+}
+
+
+
+void ComputerScreenCache::insertStaleScreen( NetworkObject::Uid uid, QSize size, const QImage& image )
+{
+	// ignore outdated requests, e.g. if the screen size has changed or live data arrived meanwhile
+	auto it = m_staleScreens.find( uid );
+	if( it != m_staleScreens.end() && it->size == size && image.isNull() == false )
+	{
+		it->image = image;
+		emit screenLoaded( uid );
+	}
+}
+
+
+
+QString ComputerScreenCache::fileName( const QString& directory, NetworkObject::Uid uid )
+{
+	return directory + QLatin1Char('/') + VeyonCore::formattedUuid( uid ) + QStringLiteral(".screen");
+}
+
+
+
+QImage ComputerScreenCache::loadScreen( const QString& directory, NetworkObject::Uid uid, QSize size )
+{
+	QFile file( fileName( directory, uid ) );
+	if( file.open( QFile::ReadOnly ) == false || file.size() < qint64( sizeof(Header) ) )
+	{
+		return {};
+	}
+
+	const auto data = file.map( 0, file.size() );
+	if( data == nullptr )
+	{
+		return {};
+	}
+
+	Header header;
+	std::memcpy( &header, data, sizeof(header) );
+
+	// do not trust any value as the file might be corrupted and calculate sizes without overflows
+	if( header.magic != Magic || header.version != Version ||
+		header.format != QImage::Format_RGB32 ||
+		header.width <= 0 || header.width > ComputerMonitoringView::MaximumComputerScreenSize ||
+		header.height <= 0 || header.height > ComputerMonitoringView::MaximumComputerScreenSize ||
+		qint64( header.bytesPerLine ) < qint64( header.width ) * 4 ||
+		qint64( sizeof(Header) ) + qint64( header.bytesPerLine ) * qint64( header.height ) > file.size() ||
+		QDateTime::currentMSecsSinceEpoch() - header.timestamp > MaximumAge )
+	{
+		file.unmap( data );
+		return {};
+	}
+
+	// wrap the mapped pixels without copying and draw them dimmed to mark the screen as outdated
+	const QImage mappedScreen( data + sizeof(Header), header.width, header.height, header.bytesPerLine,
+							   QImage::Format_RGB32 );
+	const auto screenSize = mappedScreen.size().scaled( size, Qt::KeepAspectRatio );
+
+	QImage staleScreen( screenSize, QImage::Format_ARGB32_Premultiplied );
+	staleScreen.fill( Qt::transparent );
+
+	QPainter painter( &staleScreen );
+	painter.setRenderHint( QPainter::SmoothPixmapTransform );
+	painter.setOpacity( StaleScreenOpacity );
+	painter.drawImage( staleScreen.rect(), mappedScreen );
+	painter.end();
+
+	file.unmap( data );
+
+	return staleScreen;
+}
+
+
+
+void ComputerScreenCache::writeScreens( const QString& directory, const Screens& screens )
+{
+	if( screens.isEmpty() || QDir().mkpath( directory ) == false )
+	{
+		return;
+	}
+
+	const auto timestamp = QDateTime::currentMSecsSinceEpoch();
+
+	for( auto it = screens.constBegin(), end = screens.constEnd(); it != end; ++it )
+	{
+		const auto screen = it.value().convertToFormat( QImage::Format_RGB32 );
+
+		const Header header{ Magic, Version, timestamp, screen.width(), screen.height(), screen.bytesPerLine(),
+							 QImage::Format_RGB32 };
+
+		QSaveFile file( fileName( directory, it.key() ) );
+		if( file.open( QFile::WriteOnly ) == false ||
+			file.write( reinterpret_cast<const char *>( &header ), sizeof(header) ) != qint64( sizeof(header) ) ||
+			file.write( reinterpret_cast<const char *>( screen.constBits() ),
+						qint64( screen.bytesPerLine() ) * screen.height() ) != qint64( screen.bytesPerLine() ) * screen.height() ||
+			file.commit() == false )
+		{
+			vDebug() << "could not write" << file.fileName();
+		}
+	}
+}
+
+
+
+void ComputerScreenCache::removeExpiredScreens( const QString& directory )
+{
+	const auto expiryTime = QDateTime::currentDateTime().addMSecs( -MaximumAge );
+
+	const auto screenFiles = QDir( directory ).entryInfoList( { QStringLiteral("*.screen") }, QDir::Files );
+	for( const auto& screenFile : screenFiles )
+	{
+		if( screenFile.lastModified() < expiryTime )
+		{
+			QFile::remove( screenFile.absoluteFilePath() );
+		}
+	}
+}
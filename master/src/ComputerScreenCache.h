@@ -0,0 +1,104 @@
+/*
+ * ComputerScreenCache.h - declaration of ComputerScreenCache class
+ *
+ * Copyright (c) 2019 Tobias Junghans <tobydox@veyon.io>
+ *
+ * This file is part of Veyon - https://veyon.io
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program (see COPYING); if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ *
+ */
+
+#pragma once
+
+#include <functional>
+
+#include <QHash>
+#include <QImage>
+#include <QSet>
+#include <QThread>
+#include <QTimer>
+
+#include "NetworkObject.h"
+
+// keeps the last scaled screen of each computer on disk so that it can be shown until live data arrives
+class ComputerScreenCache : public QObject
+{
+	Q_OBJECT
+public:
+	using ScreenProvider = std::function<QImage(NetworkObject::Uid)>;
+
+	explicit ComputerScreenCache( const ScreenProvider& screenProvider, QObject* parent = nullptr );
+	~ComputerScreenCache() override;
+
+	QImage cachedScreen( NetworkObject::Uid uid, QSize size );
+
+	void updateScreen( NetworkObject::Uid uid );
+	void removeScreen( NetworkObject::Uid uid );
+	void clear();
+
+	void flush();
+
+signals:
+	void screenLoaded( NetworkObject::Uid uid );
+	void staleScreenLoaded( NetworkObject::Uid uid, QSize size, const QImage& image );
+
+private:
+	using Screens = QHash<NetworkObject::Uid, QImage>;
+
+	struct Header {
+		quint32 magic;
+		quint32 version;
+		qint64 timestamp;
+		qint32 width;
+		qint32 height;
+		qint32 bytesPerLine;
+		qint32 format;
+	};
+
+	struct StaleScreen {
+		QSize size;
+		QImage image;
+	};
+
+	static constexpr quint32 Magic = 0x56534353; // "VSCS"
+	static constexpr quint32 Version = 1;
+	static constexpr int FlushInterval = 30000;
+	static constexpr qint64 MaximumAge = 7 * 24 * 60 * 60 * 1000LL;
+	static constexpr qreal StaleScreenOpacity = 0.5;
+
+	Screens takeUpdatedScreens();
+	void writeScreensInBackground( const Screens& screens );
+
+	void insertStaleScreen( NetworkObject::Uid uid, QSize size, const QImage& image );
+
+	static QString fileName( const QString& directory, NetworkObject::Uid uid );
+	static QImage loadScreen( const QString& directory, NetworkObject::Uid uid, QSize size );
+
+	static void writeScreens( const QString& directory, const Screens& screens );
+	static void removeExpiredScreens( const QString& directory );
+
+	ScreenProvider m_screenProvider;
+	QString m_directory;
+
+	QSet<NetworkObject::Uid> m_updatedScreens;
+	QHash<NetworkObject::Uid, StaleScreen> m_staleScreens;
+
+	QTimer m_flushTimer;
+	QThread m_writerThread;
+	QObject* m_writerContext;
+
+};
@@ -230,7 +230,7 @@ void NetworkObjectTreeModel::endRemoveObjects()
 
 void NetworkObjectTreeModel::updateObject( const NetworkObject& parent, int row )
 {
-	const auto index = createIndex( row, 0, parent.modelId() );
+	const auto index = createIndex( row, 0, m_directory->childId( parent.modelId(), row ) );
 
 	emit dataChanged( index, index );
 }
@@ -94,19 +94,17 @@ FeatureList VeyonMaster::subFeatures( Feature::Uid parentFeatureUid ) const
 	FeatureList features;
 
 	const auto disabledFeatures = VeyonCore::config().disabledFeatures();
-	const auto pluginUids = VeyonCore::pluginManager().pluginUids();
+	if( disabledFeatures.contains( parentFeatureUid.toString() ) )
+	{
+		return features;
+	}
 
-	for( const auto& pluginUid : pluginUids )
+	for( const auto& feature : m_featureManager->subFeatures( parentFeatureUid ) )
 	{
-		for( const auto& feature : m_featureManager->features( pluginUid ) )
+		if( feature.testFlag( Feature::Master ) &&
+			disabledFeatures.contains( feature.uid().toString() ) == false )
 		{
-			if( feature.testFlag( Feature::Master ) &&
-				feature.parentUid() == parentFeatureUid &&
-				disabledFeatures.contains( parentFeatureUid.toString() ) == false &&
-				disabledFeatures.contains( feature.uid().toString() ) == false )
-			{
-				features += feature;
-			}
+			features += feature;
 		}
 	}
 
@@ -131,6 +129,8 @@ Configuration::Object* VeyonMaster::userConfigurationObject()
 
 void VeyonMaster::reloadSubFeatures()
 {
+	m_featureManager->updateFeatures();
+
 	if( m_mainWindow )
 	{
 		m_mainWindow->reloadSubFeatures();
@@ -0,0 +1,140 @@
+/*
+ * ComputerMonitoringViewTest.cpp - tests for the computer screen size solver
+ *
+ * Copyright (c) 2019 Tobias Junghans <tobydox@veyon.io>
+ *
+ * This file is part of Veyon - https://veyon.io
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program (see COPYING); if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ *
+ */
+
+#include <QtTest>
+
+#include "ComputerMonitoringView.h"
+
+
+class ComputerMonitoringViewTest : public QObject
+{
+	Q_OBJECT
+private slots:
+	void optimalComputerScreenSize_data();
+	void optimalComputerScreenSize();
+	void optimalComputerScreenSizeGridShapes();
+
+private:
+	// finds the largest screen size for which the items fit into the viewport by trying all sizes
+	static int bruteForceComputerScreenSize( QSize viewportSize, int itemCount, int spacing, QSize decorationSize );
+
+};
+
+
+
+void ComputerMonitoringViewTest::optimalComputerScreenSize_data()
+{
+	QTest::addColumn<QSize>( "viewportSize" );
+	QTest::addColumn<int>( "itemCount" );
+	QTest::addColumn<int>( "spacing" );
+	QTest::addColumn<QSize>( "decorationSize" );
+	QTest::addColumn<int>( "expectedSize" );
+
+	QTest::newRow( "no items" ) << QSize( 800, 450 ) << 0 << 0 << QSize() << int( ComputerMonitoringView::MaximumComputerScreenSize );
+	QTest::newRow( "single item" ) << QSize( 800, 450 ) << 1 << 0 << QSize() << 800;
+	QTest::newRow( "single item in huge viewport" ) << QSize( 3000, 2000 ) << 1 << 0 << QSize() << int( ComputerMonitoringView::MaximumComputerScreenSize );
+	QTest::newRow( "1x5" ) << QSize( 1000, 100 ) << 5 << 0 << QSize() << 177;
+	QTest::newRow( "5x1" ) << QSize( 100, 1000 ) << 5 << 0 << QSize() << 100;
+	QTest::newRow( "2x2" ) << QSize( 400, 225 ) << 4 << 0 << QSize() << 199;
+	QTest::newRow( "spacing and label" ) << QSize( 500, 200 ) << 2 << 10 << QSize( 0, 20 ) << 235;
+	QTest::newRow( "overflow" ) << QSize( 200, 200 ) << 1000 << 0 << QSize() << int( ComputerMonitoringView::MinimumComputerScreenSize );
+	QTest::newRow( "empty viewport" ) << QSize( 0, 0 ) << 10 << 5 << QSize( 0, 20 ) << int( ComputerMonitoringView::MinimumComputerScreenSize );
+}
+
+
+
+void ComputerMonitoringViewTest::optimalComputerScreenSize()
+{
+	QFETCH( QSize, viewportSize );
+	QFETCH( int, itemCount );
+	QFETCH( int, spacing );
+	QFETCH( QSize, decorationSize );
+	QFETCH( int, expectedSize );
+
+	QCOMPARE( ComputerMonitoringView::optimalComputerScreenSize( viewportSize, itemCount, spacing, decorationSize ),
+			  expectedSize );
+}
+
+
+
+void ComputerMonitoringViewTest::optimalComputerScreenSizeGridShapes()
+{
+	const QVector<int> itemCounts{ 1, 2, 3, 5, 7, 12, 20, 33, 60 };
+	const QVector<QPair<int, QSize>> spacingsAndDecorations{ { 0, {} }, { 5, { 0, 18 } }, { 10, { 4, 24 } } };
+
+	for( int width = 60; width < 1300; width += 97 )
+	{
+		for( int height = 60; height < 1000; height += 83 )
+		{
+			for( const auto itemCount : itemCounts )
+			{
+				for( const auto& spacingAndDecoration : spacingsAndDecorations )
+				{
+					const QSize viewportSize( width, height );
+					const auto spacing = spacingAndDecoration.first;
+					const auto decorationSize = spacingAndDecoration.second;
+
+					const auto size = ComputerMonitoringView::optimalComputerScreenSize( viewportSize, itemCount,
+																						 spacing, decorationSize );
+					const auto expectedSize = bruteForceComputerScreenSize( viewportSize, itemCount,
+																			spacing, decorationSize );
+					if( size != expectedSize )
+					{
+						QFAIL( qPrintable( QStringLiteral("size %1 instead of %2 for %3 items in %4x%5").
+										   arg( size ).arg( expectedSize ).arg( itemCount ).arg( width ).arg( height ) ) );
+					}
+				}
+			}
+		}
+	}
+}
+
+
+
+int ComputerMonitoringViewTest::bruteForceComputerScreenSize( QSize viewportSize, int itemCount, int spacing,
+															  QSize decorationSize )
+{
+	for( int size = ComputerMonitoringView::MaximumComputerScreenSize;
+		 size > ComputerMonitoringView::MinimumComputerScreenSize; --size )
+	{
+		for( int columns = 1; columns <= itemCount; ++columns )
+		{
+			const auto rows = ( itemCount + columns - 1 ) / columns;
+			const auto cellHeight = ( viewportSize.height() - spacing ) / rows - spacing;
+
+			// screens with an aspect ratio of 16:9 plus decoration have to fit into each cell
+			if( columns * ( size + decorationSize.width() + spacing ) + spacing <= viewportSize.width() &&
+				size * 9 <= ( cellHeight - decorationSize.height() ) * 16 )
+			{
+				return size;
+			}
+		}
+	}
+
+	return ComputerMonitoringView::MinimumComputerScreenSize;
+}
+
+
+QTEST_APPLESS_MAIN(ComputerMonitoringViewTest)
+#include "ComputerMonitoringViewTest.moc"
@@ -0,0 +1,206 @@
+/*
+ * NetworkObjectModelBenchmark.cpp - benchmarks for network object models with many computers
+ *
+ * Copyright (c) 2019 Tobias Junghans <tobydox@veyon.io>
+ *
+ * This file is part of Veyon - https://veyon.io
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program (see COPYING); if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ *
+ */
+
+#include <QtTest>
+
+#include "CheckableItemProxyModel.h"
+#include "NetworkObjectDirectory.h"
+#include "NetworkObjectTreeModel.h"
+
+
+// directory with a single location containing a configurable number of synthetic computers
+class SyntheticNetworkObjectDirectory : public NetworkObjectDirectory
+{
+	Q_OBJECT
+public:
+	explicit SyntheticNetworkObjectDirectory( QObject* parent = nullptr ) :
+		NetworkObjectDirectory( parent ),
+		m_location( NetworkObject::Type::Location, QStringLiteral("Synthetic building") ),
+		m_computerCount( 0 )
+	{
+	}
+
+	const NetworkObject& location() const
+	{
+		return m_location;
+	}
+
+	void setComputerCount( int computerCount )
+	{
+		m_computerCount = computerCount;
+		update();
+	}
+
+	void update() override
+	{
+		addOrUpdateObject( m_location, NetworkObject( NetworkObject::Type::Root ) );
+		setObjectPopulated( m_location );
+
+		QSet<NetworkObject::Uid> computerUids;
+		computerUids.reserve( m_computerCount );
+
+		for( int i = 0; i < m_computerCount; ++i )
+		{
+			const NetworkObject computer( NetworkObject::Type::Host,
+										  QStringLiteral("PC%1").arg( i ),
+										  QStringLiteral("10.%1.%2.%3").arg( i / 65536 ).arg( i / 256 % 256 ).arg( i % 256 ),
+										  {}, {}, {}, m_location.uid() );
+			computerUids.insert( computer.uid() );
+			addOrUpdateObject( computer, m_location );
+		}
+
+		removeObjects( m_location, [&computerUids]( const NetworkObject& object ) {
+			return computerUids.contains( object.uid() ) == false; } );
+	}
+
+private:
+	const NetworkObject m_location;
+	int m_computerCount;
+
+};
+
+
+
+class NetworkObjectModelBenchmark : public QObject
+{
+	Q_OBJECT
+private slots:
+	void lookup_data();
+	void lookup();
+	void selectionDiff();
+	void coalescedDataChanged();
+
+};
+
+
+
+void NetworkObjectModelBenchmark::lookup_data()
+{
+	QTest::addColumn<int>( "computerCount" );
+
+	QTest::newRow( "10 computers" ) << 10;
+	QTest::newRow( "100 computers" ) << 100;
+	QTest::newRow( "1000 computers" ) << 1000;
+}
+
+
+
+void NetworkObjectModelBenchmark::lookup()
+{
+	QFETCH( int, computerCount );
+
+	SyntheticNetworkObjectDirectory directory;
+	NetworkObjectTreeModel treeModel( &directory );
+	CheckableItemProxyModel model( NetworkObjectModel::UidRole );
+	model.setSourceModel( &treeModel );
+
+	directory.setComputerCount( computerCount );
+
+	const auto locationIndex = model.index( 0, 0 );
+	QCOMPARE( model.rowCount( locationIndex ), computerCount );
+
+	// perform the same number of lookups regardless of the number of computers so the
+	// measured time per iteration only stays flat if the cost per lookup does not depend on it
+	static constexpr int LookupCount = 1000;
+
+	QBENCHMARK
+	{
+		for( int i = 0; i < LookupCount; ++i )
+		{
+			const auto computerIndex = model.index( i % computerCount, 0, locationIndex );
+			QCOMPARE( model.parent( computerIndex ), locationIndex );
+			QVERIFY( model.data( computerIndex, NetworkObjectModel::UidRole ).toUuid().isNull() == false );
+			QCOMPARE( model.data( computerIndex, Qt::CheckStateRole ).value<Qt::CheckState>(), Qt::Unchecked );
+		}
+	}
+}
+
+
+
+void NetworkObjectModelBenchmark::selectionDiff()
+{
+	SyntheticNetworkObjectDirectory directory;
+	NetworkObjectTreeModel treeModel( &directory );
+	CheckableItemProxyModel model( NetworkObjectModel::UidRole );
+	model.setSourceModel( &treeModel );
+
+	directory.setComputerCount( 10 );
+
+	const auto locationIndex = model.index( 0, 0 );
+	model.setData( locationIndex, Qt::Checked, Qt::CheckStateRole );
+
+	QBENCHMARK
+	{
+		directory.setComputerCount( 2000 );
+		QCOMPARE( model.rowCount( locationIndex ), 2000 );
+
+		directory.setComputerCount( 10 );
+		QCOMPARE( model.rowCount( locationIndex ), 10 );
+	}
+
+	// computers added to a checked location have to be checked as well
+	directory.setComputerCount( 2000 );
+	QCOMPARE( model.data( model.index( 1999, 0, locationIndex ), Qt::CheckStateRole ).value<Qt::CheckState>(),
+			  Qt::Checked );
+}
+
+
+
+void NetworkObjectModelBenchmark::coalescedDataChanged()
+{
+	static constexpr int ComputerCount = 1000;
+
+	SyntheticNetworkObjectDirectory directory;
+	NetworkObjectTreeModel treeModel( &directory );
+	CheckableItemProxyModel model( NetworkObjectModel::UidRole );
+	model.setSourceModel( &treeModel );
+
+	directory.setComputerCount( ComputerCount );
+
+	const auto locationIndex = model.index( 0, 0 );
+
+	QSignalSpy dataChangedSpy( &model, &QAbstractItemModel::dataChanged );
+
+	model.setData( locationIndex, Qt::Checked, Qt::CheckStateRole );
+
+	// one notification for the location itself and a single one covering all of its computers
+	QCOMPARE( dataChangedSpy.count(), 2 );
+
+	const auto childrenChanged = dataChangedSpy.at( 1 );
+	QCOMPARE( childrenChanged.at( 0 ).toModelIndex(), model.index( 0, 0, locationIndex ) );
+	QCOMPARE( childrenChanged.at( 1 ).toModelIndex(), model.index( ComputerCount-1, 0, locationIndex ) );
+	QCOMPARE( childrenChanged.at( 2 ).value<QVector<int>>(), QVector<int>{ Qt::CheckStateRole } );
+
+	auto checkState = Qt::Checked;
+
+	QBENCHMARK
+	{
+		checkState = checkState == Qt::Checked ? Qt::Unchecked : Qt::Checked;
+		model.setData( locationIndex, checkState, Qt::CheckStateRole );
+	}
+}
+
+
+QTEST_GUILESS_MAIN(NetworkObjectModelBenchmark)
+#include "NetworkObjectModelBenchmark.moc"
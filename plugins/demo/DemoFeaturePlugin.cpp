@@ -24,7 +24,6 @@
 
 #include <QCoreApplication>
 
-#include "AuthenticationCredentials.h"
 #include "Computer.h"
 #include "DemoClient.h"
 #include "DemoConfigurationPage.h"
@@ -173,8 +172,8 @@ bool DemoFeaturePlugin::handleFeatureMessage( VeyonServerInterface& server,
 			// add VNC server password to message
 			server.featureWorkerManager().
 					sendMessage( FeatureMessage( m_demoServerFeature.uid(), StartDemoServer ).
-								 addArgument( VncServerPort, VeyonCore::config().vncServerPort() + VeyonCore::sessionId() ).
-								 addArgument( VncServerPassword, VeyonCore::authenticationCredentials().internalVncServerPassword().toByteArray() ).
+								 addArgument( VncServerPort, server.vncServerPort() ).
+								 addArgument( VncServerPassword, server.vncServerPassword().toByteArray() ).
 								 addArgument( DemoAccessToken, message.argument( DemoAccessToken ) ) );
 		}
 		else
@@ -0,0 +1,152 @@
+/*
+ * FilePack.cpp - implementation of FilePack class
+ *
+ * Copyright (c) 2019 Tobias Junghans <tobydox@veyon.io>
+ *
+ * This file is part of Veyon - https://veyon.io
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program (see COPYING); if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ *
+ */
+
+#include <QDataStream>
+#include <QDateTime>
+#include <QDir>
+#include <QFileInfo>
+
+#include "FilePack.h"
+#include "VeyonCore.h"
+
+
+bool FilePack::write( QIODevice& pack, const QStringList& paths, const QStringList& names )
+{
+	QDataStream stream( &pack );
+	stream.setVersion( QDataStream::Qt_5_5 );
+
+	for( int i = 0; i < paths.count() && i < names.count(); ++i )
+	{
+		const QFileInfo fileInfo( paths[i] );
+		const auto permissions = static_cast<quint32>( fileInfo.permissions() );
+		const auto lastModified = fileInfo.lastModified().toMSecsSinceEpoch();
+
+		if( fileInfo.isDir() )
+		{
+			stream << static_cast<quint8>( EntryType::Directory ) << names[i] << qint64( 0 )
+				   << permissions << lastModified;
+			continue;
+		}
+
+		QFile file( paths[i] );
+		if( file.open( QFile::ReadOnly ) == false )
+		{
+			vWarning() << "skipping unreadable file" << paths[i];
+			continue;
+		}
+
+		const auto data = file.readAll();
+
+		stream << static_cast<quint8>( EntryType::File ) << names[i] << qint64( data.size() )
+			   << permissions << lastModified;
+		stream.writeRawData( data.constData(), data.size() );
+	}
+
+	return stream.status() == QDataStream::Ok;
+}
+
+
+
+bool FilePack::extract( QIODevice& pack, const QString& destinationPath, bool overwriteExistingFiles )
+{
+	QDataStream stream( &pack );
+	stream.setVersion( QDataStream::Qt_5_5 );
+
+	const QDir destinationDir( destinationPath );
+
+	while( stream.atEnd() == false )
+	{
+		quint8 type = 0;
+		QString name;
+		qint64 size = 0;
+		quint32 permissions = 0;
+		qint64 lastModified = 0;
+
+		stream >> type >> name >> size >> permissions >> lastModified;
+
+		if( stream.status() != QDataStream::Ok || size < 0 || isSafeRelativePath( name ) == false )
+		{
+			vCritical() << "invalid entry" << name;
+			return false;
+		}
+
+		const auto filePath = destinationDir.filePath( QDir::cleanPath( name ) );
+
+		if( type == static_cast<quint8>( EntryType::Directory ) )
+		{
+			destinationDir.mkpath( QDir::cleanPath( name ) );
+			continue;
+		}
+
+		if( size > pack.bytesAvailable() )
+		{
+			vCritical() << "truncated entry" << name;
+			return false;
+		}
+
+		QByteArray data( static_cast<int>( size ), Qt::Uninitialized );
+		if( stream.readRawData( data.data(), data.size() ) != data.size() )
+		{
+			vCritical() << "truncated entry" << name;
+			return false;
+		}
+
+		if( QFileInfo::exists( filePath ) && overwriteExistingFiles == false )
+		{
+			vWarning() << "not overwriting existing file" << filePath;
+			continue;
+		}
+
+		destinationDir.mkpath( QFileInfo( QDir::cleanPath( name ) ).path() );
+
+		QFile file( filePath );
+		if( file.open( QFile::WriteOnly | QFile::Truncate ) == false || file.write( data ) != data.size() )
+		{
+			vCritical() << "could not write" << filePath;
+			continue;
+		}
+
+#if QT_VERSION >= QT_VERSION_CHECK(5, 10, 0)
+		file.setFileTime( QDateTime::fromMSecsSinceEpoch( lastModified ), QFile::FileModificationTime );
+#endif
+		file.close();
+		// keep file writable for the user so it can be overwritten by later transfers
+		file.setPermissions( static_cast<QFile::Permissions>( permissions ) | QFile::ReadOwner | QFile::WriteOwner );
+	}
+
+	return true;
+}
+
+
+
+bool FilePack::isSafeRelativePath( const QString& name )
+{
+	const auto cleanName = QDir::cleanPath( name );
+
+	// never let entries escape the destination directory
+	return cleanName.isEmpty() == false &&
+			QDir::isAbsolutePath( cleanName ) == false &&
+			cleanName != QStringLiteral("..") &&
+			cleanName.startsWith( QStringLiteral("../") ) == false;
+}
@@ -22,20 +22,35 @@
  *
  */
 
+#include <algorithm>
+
+#include <QTemporaryFile>
+
+#include <lzo/lzo1x.h>
+
+#include "FilePack.h"
 #include "FileReadThread.h"
+#include "VeyonCore.h"
 
 
-FileReadThread::FileReadThread( const QString& fileName, QObject* parent ) :
+FileReadThread::FileReadThread( const QString& fileName, int chunkSize, QObject* parent ) :
 	QObject( parent ),
 	m_mutex(),
 	m_thread( new QThread ),
 	m_file( nullptr ),
-	m_currentChunk(),
 	m_timer( new QTimer ),
 	m_fileName( fileName ),
-	m_chunkReady( false ),
-	m_filePos( 0 ),
-	m_fileSize( 0 )
+	m_packedPaths(),
+	m_packedNames(),
+	m_chunkSize( chunkSize ),
+	m_fileSize( 0 ),
+	m_chunkCount( 0 ),
+	m_readError( false ),
+	m_fileHash(),
+	m_chunkHashes(),
+	m_incompressibleChunks( 0 ),
+	m_chunks(),
+	m_pendingChunks()
 {
 	m_timer->moveToThread( m_thread );
 	m_thread->start();
@@ -46,29 +61,69 @@ FileReadThread::FileReadThread( const QString& fileName, QObject* parent ) :
 
 
 
+FileReadThread::FileReadThread( const QStringList& packedPaths, const QStringList& packedNames,
+								int chunkSize, QObject* parent ) :
+	FileReadThread( tr( "%1 packed files" ).arg( packedPaths.count() ), chunkSize, parent )
+{
+	m_packedPaths = packedPaths;
+	m_packedNames = packedNames;
+}
+
+
+
 FileReadThread::~FileReadThread()
 {
 	m_thread->quit();
+	m_thread->wait();
 }
 
 
 
 bool FileReadThread::start()
 {
-	if( QFile( m_fileName ).open( QFile::ReadOnly ) == false )
+	if( m_packedPaths.isEmpty() && QFile( m_fileName ).open( QFile::ReadOnly ) == false )
 	{
 		return false;
 	}
 
-	m_timer->singleShot( 0, this, [this]() {
-		m_file = new QFile( m_fileName );
-		m_file->open( QFile::ReadOnly );
+	// use timer living in reader thread as context so the file is accessed there only
+	QTimer::singleShot( 0, m_timer, [this]() {
+		auto packError = false;
+
+		if( m_packedPaths.isEmpty() )
+		{
+			m_file = new QFile( m_fileName );
+			m_file->open( QFile::ReadOnly );
+		}
+		else
+		{
+			// pack small files into temporary file which then is transferred like a regular file
+			m_file = new QTemporaryFile;
+			packError = m_file->open( QFile::ReadWrite ) == false ||
+					FilePack::write( *m_file, m_packedPaths, m_packedNames ) == false ||
+					m_file->flush() == false;
+		}
 		connect( m_thread, &QThread::finished, m_file, &QObject::deleteLater );
 
+		const auto fileSize = m_file->size();
+		const auto chunkCount = static_cast<int>( ( fileSize + m_chunkSize - 1 ) / m_chunkSize );
+
+		QByteArray chunkHashes;
+		const auto fileHash = hashFile( *m_file, m_chunkSize, &chunkHashes );
+
 		m_mutex.lock();
-		m_filePos = 0;
-		m_fileSize = m_file->size();
+		m_fileSize = fileSize;
+		m_chunkCount = chunkCount;
+		m_fileHash = fileHash;
+		m_chunkHashes = chunkHashes;
+		if( packError || chunkHashes.size() != m_chunkCount * HashSize )
+		{
+			vCritical() << "could not read" << m_fileName << "completely";
+			m_readError = true;
+		}
 		m_mutex.unlock();
+
+		emit chunkReady();
 	} );
 
 	return true;
@@ -76,53 +131,228 @@ bool FileReadThread::start()
 
 
 
-QByteArray FileReadThread::currentChunk()
+FileReadThread::Chunk FileReadThread::chunk( int index )
 {
 	QMutexLocker lock( &m_mutex );
-	return m_currentChunk;
+
+	const auto chunk = m_chunks.value( index );
+
+	// always read the requested chunk but read ahead only as long as the cache is not exhausted
+	for( int i = index, end = qMin( index + ReadAheadChunks, m_chunkCount ); i < end; ++i )
+	{
+		if( i > index && m_chunks.size() + m_pendingChunks.size() >= MaxCachedChunks )
+		{
+			break;
+		}
+
+		if( m_chunks.contains( i ) == false && m_pendingChunks.contains( i ) == false )
+		{
+			m_pendingChunks.insert( i );
+			readChunk( i );
+		}
+	}
+
+	return chunk;
+}
+
+
+
+qint64 FileReadThread::fileSize()
+{
+	QMutexLocker lock( &m_mutex );
+	return m_fileSize;
+}
+
+
+
+int FileReadThread::chunkCount()
+{
+	QMutexLocker lock( &m_mutex );
+	return m_chunkCount;
+}
+
+
+
+bool FileReadThread::hasHashes()
+{
+	QMutexLocker lock( &m_mutex );
+	return m_fileHash.isEmpty() == false;
+}
+
+
+
+QByteArray FileReadThread::fileHash()
+{
+	QMutexLocker lock( &m_mutex );
+	return m_fileHash;
+}
+
+
+
+QByteArray FileReadThread::chunkHashes()
+{
+	QMutexLocker lock( &m_mutex );
+	return m_chunkHashes;
+}
+
+
+
+QByteArray FileReadThread::hashChunk( const QByteArray& chunk )
+{
+	return QCryptographicHash::hash( chunk, HashAlgorithm );
 }
 
 
 
-void FileReadThread::readNextChunk( qint64 chunkSize )
+QByteArray FileReadThread::hashFile( QIODevice& file, int chunkSize, QByteArray* chunkHashes )
 {
-	m_mutex.lock();
-	m_chunkReady = false;
-	m_mutex.unlock();
+	QCryptographicHash fileHash( HashAlgorithm );
 
-	m_timer->singleShot( 0, this, [this, chunkSize]() {
-		if( m_file )
+	file.seek( 0 );
+
+	while( file.atEnd() == false )
+	{
+		const auto chunk = file.read( chunkSize );
+		if( chunk.isEmpty() )
 		{
-			const auto chunk = m_file->read( chunkSize );
-			m_mutex.lock();
-			m_currentChunk = chunk;
-			m_chunkReady = true;
-			m_filePos = m_file->pos();
-			m_mutex.unlock();
+			break;
 		}
-	} );
+
+		fileHash.addData( chunk );
+		if( chunkHashes )
+		{
+			chunkHashes->append( hashChunk( chunk ) );
+		}
+	}
+
+	return fileHash.result();
 }
 
 
 
-bool FileReadThread::isChunkReady()
+QByteArray FileReadThread::compressChunk( const QByteArray& chunk )
 {
-	QMutexLocker lock( &m_mutex );
-	return m_chunkReady;
+	static const bool lzoInitialized = lzo_init() == LZO_E_OK;
+	if( lzoInitialized == false || chunk.isEmpty() )
+	{
+		return {};
+	}
+
+	QByteArray workMemory( LZO1X_1_MEM_COMPRESS, Qt::Uninitialized );
+	QByteArray compressedChunk( chunk.size() + chunk.size() / 16 + 64 + 3, Qt::Uninitialized );
+	lzo_uint compressedSize = 0;
+
+	if( lzo1x_1_compress( reinterpret_cast<const lzo_bytep>( chunk.constData() ), static_cast<lzo_uint>( chunk.size() ),
+						  reinterpret_cast<lzo_bytep>( compressedChunk.data() ), &compressedSize,
+						  workMemory.data() ) != LZO_E_OK )
+	{
+		return {};
+	}
+
+	compressedChunk.truncate( static_cast<int>( compressedSize ) );
+
+	return compressedChunk;
 }
 
 
 
-bool FileReadThread::atEnd()
+QByteArray FileReadThread::uncompressChunk( const QByteArray& compressedChunk, int size )
+{
+	static const bool lzoInitialized = lzo_init() == LZO_E_OK;
+	if( lzoInitialized == false || size <= 0 )
+	{
+		return {};
+	}
+
+	QByteArray chunk( size, Qt::Uninitialized );
+	auto uncompressedSize = static_cast<lzo_uint>( size );
+
+	if( lzo1x_decompress_safe( reinterpret_cast<const lzo_bytep>( compressedChunk.constData() ),
+							   static_cast<lzo_uint>( compressedChunk.size() ),
+							   reinterpret_cast<lzo_bytep>( chunk.data() ), &uncompressedSize, nullptr ) != LZO_E_OK ||
+		uncompressedSize != static_cast<lzo_uint>( size ) )
+	{
+		return {};
+	}
+
+	return chunk;
+}
+
+
+
+bool FileReadThread::hasReadError()
 {
 	QMutexLocker lock( &m_mutex );
-	return m_filePos >= m_fileSize;
+	return m_readError;
 }
 
 
 
-int FileReadThread::progress()
+void FileReadThread::retainChunks( const QVector<int>& cursors )
 {
 	QMutexLocker lock( &m_mutex );
-	return m_fileSize > 0 ? static_cast<int>( m_filePos * 100 / m_fileSize ) : 0;
+
+	for( auto it = m_chunks.begin(); it != m_chunks.end(); )
+	{
+		const auto index = it.key();
+		const auto needed = std::any_of( cursors.begin(), cursors.end(), [index]( int cursor ) {
+			return index >= cursor && index < cursor + ReadAheadChunks;
+		} );
+
+		it = needed ? it + 1 : m_chunks.erase( it );
+	}
+}
+
+
+
+void FileReadThread::readChunk( int index )
+{
+	QTimer::singleShot( 0, m_timer, [this, index]() {
+		QByteArray chunk;
+		if( m_file && m_file->seek( qint64( index ) * m_chunkSize ) )
+		{
+			chunk = m_file->read( m_chunkSize );
+		}
+
+		const auto compressedChunk = tryCompressChunk( chunk );
+
+		m_mutex.lock();
+		m_pendingChunks.remove( index );
+		if( chunk.isEmpty() )
+		{
+			vCritical() << "could not read chunk" << index << "of" << m_fileName;
+			m_readError = true;
+		}
+		else
+		{
+			m_chunks.insert( index, { chunk, compressedChunk } );
+		}
+		m_mutex.unlock();
+
+		emit chunkReady();
+	} );
+}
+
+
+
+QByteArray FileReadThread::tryCompressChunk( const QByteArray& chunk )
+{
+	// skip most chunks of files which turned out to be incompressible, e.g. media or archives
+	if( m_incompressibleChunks >= MaxIncompressibleChunks &&
+		m_incompressibleChunks % CompressionProbeInterval != 0 )
+	{
+		++m_incompressibleChunks;
+		return {};
+	}
+
+	const auto compressedChunk = compressChunk( chunk );
+	if( compressedChunk.isEmpty() || compressedChunk.size() > chunk.size() - chunk.size() / CompressionThreshold )
+	{
+		++m_incompressibleChunks;
+		return {};
+	}
+
+	m_incompressibleChunks = 0;
+
+	return compressedChunk;
 }
@@ -24,38 +24,87 @@
 
 #pragma once
 
+#include <QCryptographicHash>
 #include <QFile>
+#include <QHash>
 #include <QMutex>
+#include <QSet>
 #include <QTimer>
 #include <QThread>
 
+// reads chunks of a file in background and caches them for all clients currently transferring the file
 class FileReadThread : public QObject
 {
 	Q_OBJECT
 public:
-	explicit FileReadThread( const QString& fileName, QObject* parent = nullptr );
+	// MD5 is only used for detecting corrupt or already existing data and is the fastest algorithm available
+	static constexpr auto HashAlgorithm = QCryptographicHash::Md5;
+	static constexpr int HashSize = 16;
+
+	struct Chunk
+	{
+		QByteArray data;
+		QByteArray compressedData; // empty if compression did not pay off
+	};
+
+	FileReadThread( const QString& fileName, int chunkSize, QObject* parent = nullptr );
+	FileReadThread( const QStringList& packedPaths, const QStringList& packedNames,
+					int chunkSize, QObject* parent = nullptr );
 	~FileReadThread() override;
 
 	bool start();
 
-	QByteArray currentChunk();
-	void readNextChunk( qint64 chunkSize );
-	bool isChunkReady();
+	// file size and chunk count are known as soon as hashes are available
+	qint64 fileSize();
+	int chunkCount();
+
+	bool hasHashes();
+	QByteArray fileHash();
+	QByteArray chunkHashes();
+
+	static QByteArray hashChunk( const QByteArray& chunk );
+	static QByteArray hashFile( QIODevice& file, int chunkSize, QByteArray* chunkHashes = nullptr );
+
+	static QByteArray compressChunk( const QByteArray& chunk );
+	static QByteArray uncompressChunk( const QByteArray& compressedChunk, int size );
 
-	bool atEnd();
-	int progress();
+	Chunk chunk( int index );
+	bool hasReadError();
+	void retainChunks( const QVector<int>& cursors );
+
+signals:
+	void chunkReady();
 
 private:
+	void readChunk( int index );
+	QByteArray tryCompressChunk( const QByteArray& chunk );
+
+	static constexpr int ReadAheadChunks = 8;
+	static constexpr int MaxCachedChunks = 64;
+
+	// keep compressed data only if it saves at least 1/8 of the size
+	static constexpr int CompressionThreshold = 8;
+	// after several incompressible chunks only try compressing every n-th chunk
+	static constexpr int MaxIncompressibleChunks = 4;
+	static constexpr int CompressionProbeInterval = 16;
+
 	QMutex m_mutex;
 	QThread* m_thread;
 	QFile* m_file;
-	QByteArray m_currentChunk;
 
 	QTimer* m_timer;
 
 	QString m_fileName;
-	bool m_chunkReady;
-	qint64 m_filePos;
+	QStringList m_packedPaths;
+	QStringList m_packedNames;
+	int m_chunkSize;
 	qint64 m_fileSize;
+	int m_chunkCount;
+	bool m_readError;
+	QByteArray m_fileHash;
+	QByteArray m_chunkHashes;
+	int m_incompressibleChunks; // accessed from reader thread only
+	QHash<int, Chunk> m_chunks;
+	QSet<int> m_pendingChunks;
 
 };
@@ -22,6 +22,9 @@
  *
  */
 
+#include <algorithm>
+
+#include <QDirIterator>
 #include <QFileInfo>
 
 #include "FileReadThread.h"
@@ -33,12 +36,12 @@ FileTransferController::FileTransferController( FileTransferPlugin* plugin ) :
 	QObject( plugin ),
 	m_plugin( plugin ),
 	m_currentFileIndex( -1 ),
-	m_currentTransferId(),
 	m_files(),
+	m_entries(),
 	m_flags( Transfer ),
 	m_interfaces(),
-	m_fileReadThread( nullptr ),
-	m_fileState( FileStateFinished ),
+	m_clients(),
+	m_fileReadThreads(),
 	m_processTimer( this )
 {
 	m_processTimer.setInterval( ProcessInterval );
@@ -49,10 +52,7 @@ FileTransferController::FileTransferController( FileTransferPlugin* plugin ) :
 
 FileTransferController::~FileTransferController()
 {
-	if( m_fileReadThread )
-	{
-		delete m_fileReadThread;
-	}
+	qDeleteAll( m_fileReadThreads );
 }
 
 
@@ -85,7 +85,28 @@ void FileTransferController::start()
 	if( isRunning() == false && m_files.isEmpty() == false )
 	{
 		m_currentFileIndex = 0;
-		m_fileState = FileStateOpen;
+
+		m_entries.clear();
+		for( int i = 0; i < m_files.count(); ++i )
+		{
+			const QFileInfo fileInfo( m_files[i] );
+			if( fileInfo.isDir() )
+			{
+				addDirectoryEntries( i, fileInfo );
+			}
+			else
+			{
+				m_entries.append( { i, fileInfo.fileName(), fileInfo.filePath(), {}, {}, QUuid::createUuid() } );
+			}
+		}
+
+		m_clients.clear();
+		m_clients.reserve( m_interfaces.size() );
+		for( const auto& controlInterface : qAsConst(m_interfaces) )
+		{
+			m_clients.append( { controlInterface, ClientState::Transferring, 0, false, false, false, false, {}, 0, 0, 0, 0, {} } );
+		}
+
 		m_processTimer.start();
 
 		emit started();
@@ -100,13 +121,16 @@ void FileTransferController::stop()
 	{
 		m_processTimer.stop();
 
-		if( m_fileReadThread )
+		for( const auto& client : qAsConst(m_clients) )
 		{
-			delete m_fileReadThread;
-			m_fileReadThread = nullptr;
+			if( client.state == ClientState::Transferring && client.startSent )
+			{
+				m_plugin->sendCancelMessage( m_entries[client.entryIndex].transferId, { client.controlInterface } );
+			}
 		}
 
-		m_plugin->sendCancelMessage( m_currentTransferId, m_interfaces );
+		qDeleteAll( m_fileReadThreads );
+		m_fileReadThreads.clear();
 	}
 
 	emit finished();
@@ -135,146 +159,428 @@ bool FileTransferController::isRunning() const
 
 
 
+QVector<FileTransferController::ClientProgress> FileTransferController::clientProgress() const
+{
+	QVector<ClientProgress> clientProgress;
+	clientProgress.reserve( m_clients.size() );
+
+	for( const auto& client : m_clients )
+	{
+		clientProgress.append( { client.controlInterface->computer().name(), client.state, client.progress } );
+	}
+
+	return clientProgress;
+}
+
+
+
+void FileTransferController::acknowledgeChunks( const ComputerControlInterface* controlInterface,
+												QUuid transferId, int chunkCount, const QBitArray& presentChunks,
+												bool compressionSupported )
+{
+	auto client = findClient( controlInterface, transferId );
+	if( client )
+	{
+		// client confirms chunks itself from now on so no longer wait for empty message queues
+		client->startAcknowledged = true;
+		client->acknowledging = true;
+		client->compressionSupported |= compressionSupported;
+		client->acknowledgedChunks = qMax( client->acknowledgedChunks, chunkCount );
+
+		// client reports chunks it already has when starting a transfer so these can be skipped
+		const auto fileReadThread = m_fileReadThreads.value( client->entryIndex );
+		if( fileReadThread && presentChunks.size() == fileReadThread->chunkCount() )
+		{
+			client->presentChunks = presentChunks;
+		}
+		client->lastAcknowledgement.restart();
+
+		process();
+	}
+}
+
+
+
+void FileTransferController::rejectTransfer( const ComputerControlInterface* controlInterface, QUuid transferId )
+{
+	auto client = findClient( controlInterface, transferId );
+	if( client )
+	{
+		startNextFile( *client );
+
+		process();
+	}
+}
+
+
+
 void FileTransferController::process()
 {
-	switch( m_fileState )
+	if( isRunning() == false )
+	{
+		return;
+	}
+
+	for( auto& client : m_clients )
+	{
+		processClient( client );
+	}
+
+	releaseFileReadThreads();
+
+	updateProgress();
+
+	const auto transferring = std::any_of( m_clients.cbegin(), m_clients.cend(), []( const Client& client ) {
+		return client.state == ClientState::Transferring;
+	} );
+
+	if( transferring == false )
 	{
-	case FileStateOpen:
-		if( openFile() )
+		m_processTimer.stop();
+		emit finished();
+	}
+}
+
+
+
+void FileTransferController::processClient( Client& client )
+{
+	if( client.state != ClientState::Transferring )
+	{
+		return;
+	}
+
+	if( client.controlInterface->state() != ComputerControlInterface::State::Connected )
+	{
+		failClient( client );
+		return;
+	}
+
+	const auto fileReadThread = this->fileReadThread( client.entryIndex );
+	if( fileReadThread == nullptr )
+	{
+		// skip files which can't be read
+		startNextFile( client );
+		return;
+	}
+
+	const auto& entry = m_entries[client.entryIndex];
+	const auto transferId = entry.transferId;
+
+	if( fileReadThread->hasReadError() )
+	{
+		if( client.startSent )
 		{
-			m_fileState = FileStateTransferring;
+			m_plugin->sendCancelMessage( transferId, { client.controlInterface } );
 		}
-		else
+		startNextFile( client );
+		return;
+	}
+
+	if( fileReadThread->hasHashes() == false )
+	{
+		// hashes of file are required for start message and still being calculated
+		return;
+	}
+
+	if( client.startSent == false )
+	{
+		m_plugin->sendStartMessage( transferId, entry.name, entry.packedNames.isEmpty() == false,
+									fileReadThread->fileSize(), ChunkSize,
+									fileReadThread->fileHash(), fileReadThread->chunkHashes(),
+									m_flags.testFlag( OverwriteExistingFiles ), { client.controlInterface } );
+		client.startSent = true;
+		client.lastAcknowledgement.restart();
+
+		// prepare next entry in background so hashing or packing it does not delay the transfer
+		if( client.entryIndex + 1 < m_entries.count() )
 		{
-			m_fileState = FileStateFinished;
+			this->fileReadThread( client.entryIndex + 1 );
 		}
-		break;
+	}
 
-	case FileStateTransferring:
-		if( transferFile() )
+	if( transferChunks( client, fileReadThread ) )
+	{
+		// only open selected files but not the contents of selected directories
+		const auto openFileInApplication = m_flags.testFlag( OpenFilesInApplication ) &&
+				entry.packedPaths.isEmpty() && entry.name.contains( QLatin1Char('/') ) == false;
+		m_plugin->sendFinishMessage( transferId, entry.name, openFileInApplication,
+									 { client.controlInterface } );
+		startNextFile( client );
+	}
+	else if( client.acknowledging && client.acknowledgedChunks < client.sentChunks &&
+			 client.lastAcknowledgement.elapsed() > ClientTimeout )
+	{
+		vWarning() << "no acknowledgement from" << client.controlInterface->computer().hostAddress()
+				   << "within" << ClientTimeout << "ms";
+		failClient( client );
+	}
+	else
+	{
+		const auto chunkCount = fileReadThread->chunkCount();
+		const auto transferredChunks = qMin( chunkCount, client.presentChunks.count( true ) +
+											 ( client.acknowledging ? client.acknowledgedChunks : client.sentChunks ) );
+		client.progress = ( client.entryIndex * 100 +
+							( chunkCount > 0 ? transferredChunks * 100 / chunkCount : 0 ) ) / m_entries.count();
+	}
+}
+
+
+
+bool FileTransferController::transferChunks( Client& client, FileReadThread* fileReadThread )
+{
+	const auto chunkCount = fileReadThread->chunkCount();
+
+	while( client.nextChunk < chunkCount )
+	{
+		if( client.nextChunk < client.presentChunks.size() && client.presentChunks.testBit( client.nextChunk ) )
 		{
-			m_fileState = FileStateFinished;
+			++client.nextChunk;
+			continue;
 		}
-		break;
 
-	case FileStateFinished:
-		finishFile();
+		if( canSendChunk( client ) == false )
+		{
+			break;
+		}
 
-		if( ++m_currentFileIndex >= m_files.count() )
+		const auto chunk = fileReadThread->chunk( client.nextChunk );
+		if( chunk.data.isEmpty() )
 		{
-			if( m_flags.testFlag( OpenTransferFolder ) )
-			{
-				m_plugin->sendOpenTransferFolderMessage( m_interfaces );
-			}
+			// chunk is being read in background
+			break;
+		}
 
-			m_processTimer.stop();
-			emit finished();
+		if( client.compressionSupported && chunk.compressedData.isEmpty() == false )
+		{
+			m_plugin->sendDataMessage( m_entries[client.entryIndex].transferId, client.nextChunk, chunk.compressedData,
+									   chunk.data.size(), { client.controlInterface } );
 		}
 		else
 		{
-			m_fileState = FileStateOpen;
+			m_plugin->sendDataMessage( m_entries[client.entryIndex].transferId, client.nextChunk, chunk.data,
+									   0, { client.controlInterface } );
 		}
-		break;
+		++client.nextChunk;
+		++client.sentChunks;
 	}
 
-	updateProgress();
+	// finish only after all chunks have been confirmed as the server stops relaying acknowledgements then
+	return client.nextChunk >= chunkCount &&
+			( client.acknowledging == false || client.acknowledgedChunks >= client.sentChunks );
 }
 
 
 
-bool FileTransferController::openFile()
+bool FileTransferController::canSendChunk( const Client& client ) const
 {
-	if( m_currentFileIndex >= m_files.count() )
+	// chunks present on the client are not known before the start message has been acknowledged but
+	// clients of older versions never acknowledge so fall back to stop-and-wait if they do not answer in time
+	if( client.startAcknowledged == false &&
+		( client.acknowledging || client.lastAcknowledgement.elapsed() < LegacyClientTimeout ) )
 	{
 		return false;
 	}
 
-	m_fileReadThread = new FileReadThread( m_files[m_currentFileIndex], this );
+	if( client.acknowledging )
+	{
+		return client.sentChunks - client.acknowledgedChunks < WindowSize;
+	}
+
+	// client does not acknowledge chunks (yet) so fall back to stop-and-wait
+	return client.controlInterface->isMessageQueueEmpty();
+}
+
 
-	if( m_fileReadThread->start() == false )
+
+void FileTransferController::startNextFile( Client& client )
+{
+	client.startSent = false;
+	client.startAcknowledged = false;
+	client.presentChunks.clear();
+	client.nextChunk = 0;
+	client.sentChunks = 0;
+	client.acknowledgedChunks = 0;
+
+	if( ++client.entryIndex >= m_entries.count() )
 	{
-		delete m_fileReadThread;
-		m_fileReadThread = nullptr;
-		emit errorOccured( tr( "Could not open file \"%1\" for reading! Please check your permissions!" ).arg( m_currentFileIndex ) );
-		return false;
+		if( m_flags.testFlag( OpenTransferFolder ) )
+		{
+			m_plugin->sendOpenTransferFolderMessage( { client.controlInterface } );
+		}
+
+		client.state = ClientState::Finished;
+		client.progress = 100;
 	}
+}
 
-	// start reading initial chunk in background
-	m_fileReadThread->readNextChunk( ChunkSize );
 
-	m_currentTransferId = QUuid::createUuid();
 
-	m_plugin->sendStartMessage( m_currentTransferId, QFileInfo( m_files[m_currentFileIndex] ).fileName(),
-								m_flags.testFlag( OverwriteExistingFiles ), m_interfaces );
+void FileTransferController::failClient( Client& client )
+{
+	if( client.startSent )
+	{
+		m_plugin->sendCancelMessage( m_entries[client.entryIndex].transferId, { client.controlInterface } );
+	}
 
-	return true;
+	client.state = ClientState::Failed;
 }
 
 
 
-bool FileTransferController::transferFile()
+FileTransferController::Client* FileTransferController::findClient( const ComputerControlInterface* controlInterface,
+																	QUuid transferId )
 {
-	if( m_fileReadThread == nullptr )
+	for( auto& client : m_clients )
 	{
-		// something went wrong so finish this file
-		return true;
+		if( client.controlInterface.data() == controlInterface )
+		{
+			if( client.state == ClientState::Transferring && m_entries[client.entryIndex].transferId == transferId )
+			{
+				return &client;
+			}
+			break;
+		}
 	}
 
-	// wait for all clients to catch up and current data chunk to be read completely
-	if( allQueuesEmpty() == false || m_fileReadThread->isChunkReady() == false )
+	return nullptr;
+}
+
+
+
+FileReadThread* FileTransferController::fileReadThread( int entryIndex )
+{
+	const auto it = m_fileReadThreads.constFind( entryIndex );
+	if( it != m_fileReadThreads.constEnd() )
 	{
-		return false;
+		return *it;
 	}
 
-	m_plugin->sendDataMessage( m_currentTransferId, m_fileReadThread->currentChunk(), m_interfaces );
+	const auto& entry = m_entries[entryIndex];
+
+	auto fileReadThread = entry.packedPaths.isEmpty() ?
+							  new FileReadThread( entry.path, ChunkSize, this ) :
+							  new FileReadThread( entry.packedPaths, entry.packedNames, ChunkSize, this );
+
+	if( fileReadThread->start() )
+	{
+		connect( fileReadThread, &FileReadThread::chunkReady, this, &FileTransferController::process );
+	}
+	else
+	{
+		delete fileReadThread;
+		fileReadThread = nullptr;
+		emit errorOccured( tr( "Could not open file \"%1\" for reading! Please check your permissions!" ).arg( entry.path ) );
+	}
 
-	m_fileReadThread->readNextChunk( ChunkSize );
+	// also remember failures so the file is not tried again for every client
+	m_fileReadThreads.insert( entryIndex, fileReadThread );
 
-	return m_fileReadThread->atEnd();
+	return fileReadThread;
 }
 
 
 
-void FileTransferController::finishFile()
+void FileTransferController::releaseFileReadThreads()
 {
-	if( m_fileReadThread )
+	for( auto it = m_fileReadThreads.begin(); it != m_fileReadThreads.end(); )
 	{
-		delete m_fileReadThread;
-		m_fileReadThread = nullptr;
+		QVector<int> cursors;
+		bool needed = false;
 
-		m_plugin->sendFinishMessage( m_currentTransferId, QFileInfo( m_files[m_currentFileIndex] ).fileName(),
-									 m_flags.testFlag( OpenFilesInApplication ), m_interfaces );
+		for( const auto& client : qAsConst(m_clients) )
+		{
+			if( client.state == ClientState::Transferring && client.entryIndex <= it.key() )
+			{
+				needed = true;
+				if( client.entryIndex == it.key() )
+				{
+					cursors.append( client.nextChunk );
+				}
+			}
+		}
 
-		m_currentTransferId = QUuid();
+		if( needed )
+		{
+			if( it.value() )
+			{
+				it.value()->retainChunks( cursors );
+			}
+			++it;
+		}
+		else
+		{
+			delete it.value();
+			it = m_fileReadThreads.erase( it );
+		}
 	}
 }
 
 
 
-void FileTransferController::updateProgress()
+void FileTransferController::addDirectoryEntries( int fileIndex, const QFileInfo& directory )
 {
-	if( m_files.isEmpty() == false && m_fileReadThread )
+	// names of entries are relative to the parent directory so the selected directory is recreated
+	const auto baseDirectory = directory.dir();
+
+	Entry pack{ fileIndex, {}, {}, { directory.filePath() }, { directory.fileName() }, QUuid::createUuid() };
+	qint64 packSize = 0;
+
+	QDirIterator it( directory.filePath(), QDir::Files | QDir::Dirs | QDir::Hidden | QDir::NoDotAndDotDot,
+					 QDirIterator::Subdirectories );
+	while( it.hasNext() )
 	{
-		emit progressChanged( m_currentFileIndex * 100 / m_files.count() +
-							  m_fileReadThread->progress() / m_files.count() );
+		const auto path = it.next();
+		const auto fileInfo = it.fileInfo();
+		const auto name = baseDirectory.relativeFilePath( path );
+
+		if( fileInfo.isFile() && fileInfo.size() >= SmallFileSize )
+		{
+			m_entries.append( { fileIndex, name, path, {}, {}, QUuid::createUuid() } );
+			continue;
+		}
+
+		// small files and directories are packed into a single stream to avoid per-file round trips
+		pack.packedPaths.append( path );
+		pack.packedNames.append( name );
+		packSize += fileInfo.isFile() ? fileInfo.size() : 0;
+
+		if( packSize >= MaxPackSize )
+		{
+			m_entries.append( pack );
+			pack = { fileIndex, {}, {}, {}, {}, QUuid::createUuid() };
+			packSize = 0;
+		}
 	}
-	else if( m_files.count() > 0 && m_currentFileIndex >= m_files.count() )
+
+	if( pack.packedPaths.isEmpty() == false )
 	{
-		emit progressChanged( 100 );
+		m_entries.append( pack );
 	}
 }
 
 
 
-bool FileTransferController::allQueuesEmpty()
+void FileTransferController::updateProgress()
 {
-	for( const auto& controlInterface : qAsConst(m_interfaces) )
+	int progressSum = 0;
+	int clientCount = 0;
+
+	m_currentFileIndex = m_files.count();
+
+	for( const auto& client : qAsConst(m_clients) )
 	{
-		if( controlInterface->isMessageQueueEmpty() == false )
+		if( client.state == ClientState::Transferring )
+		{
+			m_currentFileIndex = qMin( m_currentFileIndex, m_entries[client.entryIndex].fileIndex );
+		}
+
+		if( client.state != ClientState::Failed )
 		{
-			return false;
+			progressSum += client.progress;
+			++clientCount;
 		}
 	}
 
-	return true;
+	emit progressChanged( clientCount > 0 ? progressSum / clientCount : 100 );
 }
@@ -24,10 +24,13 @@
 
 #pragma once
 
+#include <QBitArray>
+#include <QElapsedTimer>
 #include <QTimer>
 
 #include "ComputerControlInterface.h"
 
+class QFileInfo;
 class FileReadThread;
 class FileTransferPlugin;
 
@@ -44,6 +47,19 @@ public:
 	Q_DECLARE_FLAGS(Flags, Flag)
 	Q_FLAG(Flags)
 
+	enum class ClientState {
+		Transferring,
+		Finished,
+		Failed
+	};
+
+	struct ClientProgress
+	{
+		QString computerName;
+		ClientState state;
+		int progress;
+	};
+
 	explicit FileTransferController( FileTransferPlugin* plugin );
 	~FileTransferController() override;
 
@@ -60,6 +76,12 @@ public:
 
 	bool isRunning() const;
 
+	QVector<ClientProgress> clientProgress() const;
+
+	void acknowledgeChunks( const ComputerControlInterface* controlInterface, QUuid transferId, int chunkCount,
+							const QBitArray& presentChunks, bool compressionSupported );
+	void rejectTransfer( const ComputerControlInterface* controlInterface, QUuid transferId );
+
 signals:
 	void errorOccured( const QString& message );
 	void filesChanged();
@@ -68,36 +90,69 @@ signals:
 	void finished();
 
 private:
-	enum FileState {
-		FileStateOpen,
-		FileStateTransferring,
-		FileStateFinished
+	// every client transfers the files with its own cursor so slow clients do not hold back others
+	struct Client
+	{
+		ComputerControlInterface::Pointer controlInterface;
+		ClientState state;
+		int entryIndex;
+		bool startSent;
+		bool startAcknowledged;
+		bool acknowledging;
+		bool compressionSupported;
+		QBitArray presentChunks;
+		int nextChunk;
+		int sentChunks;
+		int acknowledgedChunks;
+		int progress;
+		QElapsedTimer lastAcknowledgement;
+	};
+
+	// unit of transfer: either a single file or a pack of small files and directories
+	struct Entry
+	{
+		int fileIndex;
+		QString name;
+		QString path;
+		QStringList packedPaths;
+		QStringList packedNames;
+		QUuid transferId;
 	};
 
 	void process();
 
-	bool openFile();
-	bool transferFile();
-	void finishFile();
+	void processClient( Client& client );
+	bool transferChunks( Client& client, FileReadThread* fileReadThread );
+	bool canSendChunk( const Client& client ) const;
+	void startNextFile( Client& client );
+	void failClient( Client& client );
+	Client* findClient( const ComputerControlInterface* controlInterface, QUuid transferId );
 
-	void updateProgress();
+	FileReadThread* fileReadThread( int entryIndex );
+	void releaseFileReadThreads();
 
-	bool allQueuesEmpty();
+	void addDirectoryEntries( int fileIndex, const QFileInfo& directory );
+
+	void updateProgress();
 
 	static constexpr int ProcessInterval = 25;
 	static constexpr int ChunkSize = 256*1024;
+	static constexpr int WindowSize = 8;
+	static constexpr int ClientTimeout = 30000;
+	static constexpr int LegacyClientTimeout = 3000;
+	static constexpr qint64 SmallFileSize = ChunkSize;
+	static constexpr qint64 MaxPackSize = 16*1024*1024;
 
 	FileTransferPlugin* m_plugin;
 
 	int m_currentFileIndex;
-	QUuid m_currentTransferId;
 	QStringList m_files;
+	QVector<Entry> m_entries;
 	Flags m_flags;
 	ComputerControlInterfaceList m_interfaces;
+	QVector<Client> m_clients;
 
-	FileReadThread* m_fileReadThread;
-
-	FileState m_fileState;
+	QHash<int, FileReadThread*> m_fileReadThreads;
 
 	QTimer m_processTimer;
 
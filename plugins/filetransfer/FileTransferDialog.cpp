@@ -22,6 +22,7 @@
  *
  */
 
+#include <QFileDialog>
 #include <QPushButton>
 
 #include "FileTransferController.h"
@@ -41,6 +42,8 @@ FileTransferDialog::FileTransferDialog( FileTransferController* controller, QWid
 
 	ui->fileListView->setModel( m_listModel );
 
+	connect( ui->addDirectoryButton, &QPushButton::clicked, this, &FileTransferDialog::addDirectory );
+
 	connect( m_controller, &FileTransferController::progressChanged,
 			 this, &FileTransferDialog::updateProgress );
 
@@ -62,6 +65,7 @@ FileTransferDialog::~FileTransferDialog()
 void FileTransferDialog::accept()
 {
 	ui->optionsGroupBox->setDisabled( true );
+	ui->addDirectoryButton->setDisabled( true );
 	ui->buttonBox->setStandardButtons( QDialogButtonBox::Cancel );
 
 	FileTransferController::Flags flags( FileTransferController::Transfer );
@@ -99,6 +103,18 @@ void FileTransferDialog::reject()
 
 
 
+void FileTransferDialog::addDirectory()
+{
+	const auto directory = QFileDialog::getExistingDirectory( this, tr( "Select directory to transfer" ) );
+
+	if( directory.isEmpty() == false )
+	{
+		m_controller->setFiles( m_controller->files() + QStringList( directory ) );
+	}
+}
+
+
+
 void FileTransferDialog::finish()
 {
 	ui->buttonBox->setStandardButtons( QDialogButtonBox::Close );
@@ -111,4 +127,33 @@ void FileTransferDialog::finish()
 void FileTransferDialog::updateProgress( int progress )
 {
 	ui->progressBar->setValue( progress );
+
+	const auto clientProgress = m_controller->clientProgress();
+
+	if( ui->computerProgressList->topLevelItemCount() != clientProgress.count() )
+	{
+		ui->computerProgressList->clear();
+		for( const auto& client : clientProgress )
+		{
+			ui->computerProgressList->addTopLevelItem( new QTreeWidgetItem( { client.computerName } ) );
+		}
+	}
+
+	for( int i = 0; i < clientProgress.count(); ++i )
+	{
+		const auto& client = clientProgress[i];
+
+		switch( client.state )
+		{
+		case FileTransferController::ClientState::Transferring:
+			ui->computerProgressList->topLevelItem( i )->setText( 1, QStringLiteral("%1 %").arg( client.progress ) );
+			break;
+		case FileTransferController::ClientState::Finished:
+			ui->computerProgressList->topLevelItem( i )->setText( 1, tr( "Finished" ) );
+			break;
+		case FileTransferController::ClientState::Failed:
+			ui->computerProgressList->topLevelItem( i )->setText( 1, tr( "Failed" ) );
+			break;
+		}
+	}
 }
@@ -39,6 +39,7 @@ public:
 private:
 	void accept() override;
 	void reject() override;
+	void addDirectory();
 	void finish();
 
 	void updateProgress( int progress );
@@ -22,17 +22,22 @@
  *
  */
 
+#include <QDateTime>
 #include <QDesktopServices>
 #include <QFileDialog>
 #include <QFileInfo>
 #include <QMessageBox>
 #include <QQuickWindow>
+#include <QStandardPaths>
 
 #include "BuiltinFeatures.h"
+#include "FilePack.h"
+#include "FileReadThread.h"
 #include "FileTransferController.h"
 #include "FileTransferDialog.h"
 #include "FileTransferPlugin.h"
 #include "FileTransferUserConfiguration.h"
+#include "FileWriteThread.h"
 #include "FeatureWorkerManager.h"
 #include "QmlCore.h"
 #include "SystemTrayIcon.h"
@@ -52,8 +57,20 @@ FileTransferPlugin::FileTransferPlugin( QObject* parent ) :
 						   QStringLiteral(":/filetransfer/applications-office.png") ),
 	m_features( { m_fileTransferFeature } ),
 	m_fileTransferController( nullptr ),
-	m_currentFile(),
-	m_currentTransferId()
+	m_transferContexts(),
+	m_fileWriteThread( nullptr ),
+	m_currentTransferId(),
+	m_destinationFileName(),
+	m_chunkSize( 0 ),
+	m_fileHash(),
+	m_chunkHashes(),
+	m_packedFiles( false ),
+	m_overwriteExistingFiles( false ),
+	m_transferComplete( false ),
+	m_receivedChunks( 0 ),
+	m_writeOffset( 0 ),
+	m_preparingTransfer( false ),
+	m_pendingChunkMessages()
 {
 }
 
@@ -132,8 +149,28 @@ bool FileTransferPlugin::handleFeatureMessage( VeyonMasterInterface& master, con
 											   ComputerControlInterface::Pointer computerControlInterface )
 {
 	Q_UNUSED(master)
-	Q_UNUSED(message)
-	Q_UNUSED(computerControlInterface)
+
+	if( message.featureUid() == m_fileTransferFeature.uid() && m_fileTransferController )
+	{
+		switch( message.command() )
+		{
+		case FileTransferAcknowledgeCommand:
+			m_fileTransferController->acknowledgeChunks( computerControlInterface.data(),
+														 message.argument( TransferId ).toUuid(),
+														 message.argument( AcknowledgedChunks ).toInt(),
+														 message.argument( PresentChunks ).toBitArray(),
+														 message.argument( CompressionSupported ).toBool() );
+			return true;
+
+		case FileTransferRejectCommand:
+			m_fileTransferController->rejectTransfer( computerControlInterface.data(),
+													  message.argument( TransferId ).toUuid() );
+			return true;
+
+		default:
+			break;
+		}
+	}
 
 	return false;
 }
@@ -144,10 +181,44 @@ bool FileTransferPlugin::handleFeatureMessage( VeyonServerInterface& server,
 											   const MessageContext& messageContext,
 											   const FeatureMessage& message )
 {
-	Q_UNUSED(messageContext)
-
 	if( m_fileTransferFeature.uid() == message.featureUid() )
 	{
+		const auto transferId = message.argument( TransferId ).toUuid();
+
+		if( message.command() == FileTransferAcknowledgeCommand ||
+			message.command() == FileTransferRejectCommand )
+		{
+			// relay reply from worker to master
+			const auto context = m_transferContexts.constFind( transferId );
+			if( context != m_transferContexts.constEnd() && context->ioDevice() )
+			{
+				server.sendFeatureMessageReply( *context, message );
+			}
+			if( message.command() == FileTransferRejectCommand )
+			{
+				m_transferContexts.remove( transferId );
+			}
+			return true;
+		}
+
+		switch( message.command() )
+		{
+		case FileTransferStartCommand:
+			// forget transfers of masters which disconnected meanwhile
+			for( auto it = m_transferContexts.begin(); it != m_transferContexts.end(); )
+			{
+				it = it->ioDevice() ? it + 1 : m_transferContexts.erase( it );
+			}
+			m_transferContexts.insert( transferId, messageContext );
+			break;
+		case FileTransferCancelCommand:
+		case FileTransferFinishCommand:
+			m_transferContexts.remove( transferId );
+			break;
+		default:
+			break;
+		}
+
 		if( server.featureWorkerManager().isWorkerRunning( m_fileTransferFeature ) == false )
 		{
 			server.featureWorkerManager().startWorker( m_fileTransferFeature, FeatureWorkerManager::UnmanagedSessionProcess );
@@ -155,9 +226,10 @@ bool FileTransferPlugin::handleFeatureMessage( VeyonServerInterface& server,
 
 		if( message.command() == FileTransferFinishCommand )
 		{
+			const auto fileName = message.argument( Filename ).toString();
 			VeyonCore::builtinFeatures().systemTrayIcon().showMessage( m_fileTransferFeature.displayName(),
-																	   tr( "Received file \"%1\"." ).
-																	   arg( message.argument( Filename ).toString() ),
+																	   fileName.isEmpty() ? tr( "Received files." ) :
+																	   tr( "Received file \"%1\"." ).arg( fileName ),
 																	   server.featureWorkerManager() );
 		}
 
@@ -174,40 +246,18 @@ bool FileTransferPlugin::handleFeatureMessage( VeyonServerInterface& server,
 
 bool FileTransferPlugin::handleFeatureMessage( VeyonWorkerInterface& worker, const FeatureMessage& message )
 {
-	Q_UNUSED(worker)
-
 	if( m_fileTransferFeature.uid() == message.featureUid() )
 	{
 		switch( message.command() )
 		{
 		case FileTransferStartCommand:
-			m_currentFile.close();
-			// TODO: make path configurable
-			m_currentFile.setFileName( QDir::homePath() + QDir::separator() + message.argument( Filename ).toString() );
-			if( m_currentFile.exists() && message.argument( OverwriteExistingFile ).toBool() == false )
-			{
-				QMessageBox::critical( nullptr, m_fileTransferFeature.displayName(),
-									   tr( "Could not receive file \"%1\" as it already exists." ).
-									   arg( m_currentFile.fileName() ) );
-				return true;
-			}
-
-			if( m_currentFile.open( QFile::WriteOnly | QFile::Truncate ) )
-			{
-				m_currentTransferId = message.argument( TransferId ).toUuid();
-			}
-			else
-			{
-				QMessageBox::critical( nullptr, m_fileTransferFeature.displayName(),
-									   tr( "Could not receive file \"%1\" as it could not be opened for writing!" ).
-									   arg( m_currentFile.fileName() ) );
-			}
+			startTransfer( worker, message );
 			return true;
 
 		case FileTransferContinueCommand:
 			if( message.argument( TransferId ).toUuid() == m_currentTransferId )
 			{
-				m_currentFile.write( message.argument( DataChunk ).toByteArray() );
+				receiveChunk( worker, message );
 			}
 			else
 			{
@@ -218,7 +268,8 @@ bool FileTransferPlugin::handleFeatureMessage( VeyonWorkerInterface& worker, con
 		case FileTransferCancelCommand:
 			if( message.argument( TransferId ).toUuid() == m_currentTransferId )
 			{
-				m_currentFile.remove();
+				// keep partial files of verified transfers so they can be resumed later
+				cancelTransfer( m_fileHash.isEmpty() );
 			}
 			else
 			{
@@ -227,12 +278,7 @@ bool FileTransferPlugin::handleFeatureMessage( VeyonWorkerInterface& worker, con
 			return true;
 
 		case FileTransferFinishCommand:
-			m_currentFile.close();
-			if( message.argument( OpenFileInApplication ).toBool() )
-			{
-				QDesktopServices::openUrl( QUrl::fromLocalFile( m_currentFile.fileName() ) );
-			}
-			m_currentFile.setFileName( {} );
+			finishTransfer( message );
 			return true;
 
 		case OpenTransferFolder:
@@ -249,25 +295,39 @@ bool FileTransferPlugin::handleFeatureMessage( VeyonWorkerInterface& worker, con
 
 
 
-void FileTransferPlugin::sendStartMessage( QUuid transferId, const QString& fileName,
+void FileTransferPlugin::sendStartMessage( QUuid transferId, const QString& fileName, bool packedFiles,
+										   qint64 fileSize, int chunkSize,
+										   const QByteArray& fileHash, const QByteArray& chunkHashes,
 										   bool overwriteExistingFile, const ComputerControlInterfaceList& interfaces )
 {
 	sendFeatureMessage( FeatureMessage( m_fileTransferFeature.uid(), FileTransferStartCommand ).
 						addArgument( TransferId, transferId ).
 						addArgument( Filename, fileName ).
-						addArgument( OverwriteExistingFile, overwriteExistingFile ),
+						addArgument( PackedFiles, packedFiles ).
+						addArgument( OverwriteExistingFile, overwriteExistingFile ).
+						addArgument( FileSize, fileSize ).
+						addArgument( ChunkSize, chunkSize ).
+						addArgument( FileHash, fileHash ).
+						addArgument( ChunkHashes, chunkHashes ),
 						interfaces );
 }
 
 
 
-void FileTransferPlugin::sendDataMessage( QUuid transferId, const QByteArray& data,
-										  const ComputerControlInterfaceList& interfaces )
+void FileTransferPlugin::sendDataMessage( QUuid transferId, int chunkIndex, const QByteArray& data,
+										  int uncompressedSize, const ComputerControlInterfaceList& interfaces )
 {
-	sendFeatureMessage( FeatureMessage( m_fileTransferFeature.uid(), FileTransferContinueCommand ).
-						addArgument( TransferId, transferId ).
-						addArgument( DataChunk, data ),
-						interfaces );
+	FeatureMessage message( m_fileTransferFeature.uid(), FileTransferContinueCommand );
+	message.addArgument( TransferId, transferId ).
+			addArgument( ChunkIndex, chunkIndex ).
+			addArgument( DataChunk, data );
+
+	if( uncompressedSize > 0 )
+	{
+		message.addArgument( UncompressedSize, uncompressedSize );
+	}
+
+	sendFeatureMessage( message, interfaces );
 }
 
 
@@ -324,3 +384,331 @@ void FileTransferPlugin::startFileTransfer( const QStringList& files, Configurat
 	m_fileTransferController->setFiles( relativeFiles );
 	m_fileTransferController->setInterfaces( interfaces );
 }
+
+
+
+void FileTransferPlugin::startTransfer( VeyonWorkerInterface& worker, const FeatureMessage& message )
+{
+	cancelTransfer( false );
+
+	m_receivedChunks = 0;
+	m_writeOffset = 0;
+	m_transferComplete = false;
+
+	const auto transferId = message.argument( TransferId ).toUuid();
+	const auto fileSize = message.argument( FileSize ).toLongLong();
+	m_chunkSize = message.argument( ChunkSize ).toInt();
+	m_fileHash = message.argument( FileHash ).toByteArray();
+	m_chunkHashes = message.argument( ChunkHashes ).toByteArray();
+	m_packedFiles = message.argument( PackedFiles ).toBool();
+	m_overwriteExistingFiles = message.argument( OverwriteExistingFile ).toBool();
+
+	// masters of older versions do not send hashes and expect chunks to be appended
+	if( m_chunkSize <= 0 )
+	{
+		m_fileHash.clear();
+		m_packedFiles = false;
+	}
+
+	const auto fileName = message.argument( Filename ).toString();
+	if( m_packedFiles == false && FilePack::isSafeRelativePath( fileName ) == false )
+	{
+		vCritical() << "refusing to receive file with invalid name" << fileName;
+		sendRejectMessage( worker, transferId );
+		return;
+	}
+
+	// TODO: make path configurable
+	m_destinationFileName = m_packedFiles ? QDir::homePath() :
+											QDir::homePath() + QDir::separator() + QDir::cleanPath( fileName );
+
+	if( m_fileHash.isEmpty() )
+	{
+		receiveFile( worker, transferId, fileSize, {} );
+		return;
+	}
+
+	// accept chunks sent by the master while the partial file is being prepared
+	m_currentTransferId = transferId;
+	m_preparingTransfer = true;
+
+	// receive into partial file named after the content so interrupted transfers can be resumed
+	const auto fileWriteThread = new FileWriteThread( partialFileName( m_fileHash ), this );
+	m_fileWriteThread = fileWriteThread;
+
+	connect( fileWriteThread, &FileWriteThread::prepared, this,
+			 [=, &worker]( bool identicalFile, const QBitArray& presentChunks ) {
+		if( fileWriteThread != m_fileWriteThread )
+		{
+			// transfer has been cancelled in the meantime
+			return;
+		}
+
+		if( identicalFile )
+		{
+			// identical file exists already so report all chunks as present and already sent ones as received
+			cancelTransfer( false );
+			m_currentTransferId = transferId;
+			m_transferComplete = true;
+			m_receivedChunks = presentChunks.size();
+			sendAcknowledgeMessage( worker, presentChunks );
+			return;
+		}
+
+		const auto pendingChunkMessages = m_pendingChunkMessages;
+		m_pendingChunkMessages.clear();
+		m_preparingTransfer = false;
+
+		if( receiveFile( worker, transferId, fileSize, presentChunks ) )
+		{
+			for( const auto& chunkMessage : pendingChunkMessages )
+			{
+				receiveChunk( worker, chunkMessage );
+			}
+		}
+	} );
+
+	fileWriteThread->prepare( m_packedFiles ? QString() : m_destinationFileName, m_overwriteExistingFiles,
+							  fileSize, m_fileHash, m_chunkHashes, m_chunkSize );
+}
+
+
+
+bool FileTransferPlugin::receiveFile( VeyonWorkerInterface& worker, QUuid transferId, qint64 fileSize,
+									  const QBitArray& presentChunks )
+{
+	if( m_packedFiles == false && QFile::exists( m_destinationFileName ) && m_overwriteExistingFiles == false )
+	{
+		cancelTransfer( false );
+
+		// let master continue with next file while the message box is shown
+		sendRejectMessage( worker, transferId );
+		QMessageBox::critical( nullptr, m_fileTransferFeature.displayName(),
+							   tr( "Could not receive file \"%1\" as it already exists." ).
+							   arg( m_destinationFileName ) );
+		return false;
+	}
+
+	if( m_packedFiles == false )
+	{
+		// file may be part of a transferred directory
+		QDir().mkpath( QFileInfo( m_destinationFileName ).absolutePath() );
+	}
+
+	if( m_fileWriteThread == nullptr )
+	{
+		m_fileWriteThread = new FileWriteThread( m_destinationFileName, this );
+	}
+
+	if( m_fileWriteThread->start( fileSize, m_fileHash.isEmpty() ) == false )
+	{
+		cancelTransfer( false );
+
+		sendRejectMessage( worker, transferId );
+		QMessageBox::critical( nullptr, m_fileTransferFeature.displayName(),
+							   tr( "Could not receive file \"%1\" as it could not be opened for writing!" ).
+							   arg( m_destinationFileName ) );
+		return false;
+	}
+
+	// acknowledge chunks not before they have been written so a slow disk throttles the master
+	connect( m_fileWriteThread, &FileWriteThread::chunksWritten, this, [this, &worker, transferId]( int count ) {
+		if( transferId == m_currentTransferId )
+		{
+			m_receivedChunks += count;
+			sendAcknowledgeMessage( worker );
+		}
+	} );
+
+	m_currentTransferId = transferId;
+
+	// presentChunks is null for masters which do not send hashes
+	sendAcknowledgeMessage( worker, presentChunks );
+
+	return true;
+}
+
+
+
+void FileTransferPlugin::receiveChunk( VeyonWorkerInterface& worker, const FeatureMessage& message )
+{
+	if( m_preparingTransfer )
+	{
+		m_pendingChunkMessages.append( message );
+		return;
+	}
+
+	if( m_fileWriteThread == nullptr )
+	{
+		return;
+	}
+
+	auto data = message.argument( DataChunk ).toByteArray();
+	const auto chunkIndex = message.argument( ChunkIndex );
+
+	const auto uncompressedSize = message.argument( UncompressedSize ).toInt();
+	if( uncompressedSize > 0 )
+	{
+		// chunk hash check below fails for chunks which could not be decompressed
+		data = FileReadThread::uncompressChunk( data, uncompressedSize );
+	}
+
+	if( m_fileHash.isEmpty() == false && chunkIndex.isValid() )
+	{
+		const auto index = chunkIndex.toInt();
+		if( FileReadThread::hashChunk( data ) !=
+			m_chunkHashes.mid( index * FileReadThread::HashSize, FileReadThread::HashSize ) )
+		{
+			vCritical() << "checksum mismatch for chunk" << index << "of" << m_destinationFileName;
+			cancelTransfer( false );
+			sendRejectMessage( worker, message.argument( TransferId ).toUuid() );
+			return;
+		}
+
+		m_writeOffset = qint64( index ) * m_chunkSize;
+	}
+
+	m_fileWriteThread->write( m_writeOffset, data );
+	m_writeOffset += data.size();
+}
+
+
+
+void FileTransferPlugin::finishTransfer( const FeatureMessage& message )
+{
+	if( message.argument( TransferId ).toUuid() != m_currentTransferId )
+	{
+		vWarning() << "received finish message for unknown transfer ID";
+		return;
+	}
+
+	m_currentTransferId = QUuid();
+
+	const auto openFileInApplication = message.argument( OpenFileInApplication ).toBool();
+
+	if( m_transferComplete || m_fileWriteThread == nullptr )
+	{
+		if( openFileInApplication )
+		{
+			QDesktopServices::openUrl( QUrl::fromLocalFile( m_destinationFileName ) );
+		}
+		return;
+	}
+
+	const auto fileWriteThread = m_fileWriteThread;
+	m_fileWriteThread = nullptr;
+
+	const auto destinationFileName = m_destinationFileName;
+	const auto verified = m_fileHash.isEmpty() == false;
+	const auto packedFiles = m_packedFiles;
+	const auto overwriteExistingFiles = m_overwriteExistingFiles;
+
+	connect( fileWriteThread, &FileWriteThread::finished, this,
+			 [=]( bool success ) {
+		fileWriteThread->deleteLater();
+
+		if( success == false )
+		{
+			vCritical() << "could not receive file" << destinationFileName;
+			if( verified )
+			{
+				QFile::remove( fileWriteThread->fileName() );
+			}
+			return;
+		}
+
+		if( packedFiles )
+		{
+			QFile pack( fileWriteThread->fileName() );
+			if( pack.open( QFile::ReadOnly ) == false ||
+				FilePack::extract( pack, destinationFileName, overwriteExistingFiles ) == false )
+			{
+				vCritical() << "could not extract received files";
+			}
+			pack.remove();
+			return;
+		}
+
+		if( verified )
+		{
+			QFile::remove( destinationFileName );
+			if( QFile::rename( fileWriteThread->fileName(), destinationFileName ) == false )
+			{
+				vCritical() << "could not move received file to" << destinationFileName;
+				return;
+			}
+		}
+
+		if( openFileInApplication )
+		{
+			QDesktopServices::openUrl( QUrl::fromLocalFile( destinationFileName ) );
+		}
+	} );
+
+	fileWriteThread->finish( m_fileHash, m_chunkSize );
+}
+
+
+
+void FileTransferPlugin::cancelTransfer( bool removeFile )
+{
+	if( m_fileWriteThread )
+	{
+		m_fileWriteThread->cancel( removeFile );
+		delete m_fileWriteThread;
+		m_fileWriteThread = nullptr;
+	}
+
+	m_preparingTransfer = false;
+	m_pendingChunkMessages.clear();
+
+	m_currentTransferId = QUuid();
+}
+
+
+
+QString FileTransferPlugin::partialFileName( const QByteArray& fileHash )
+{
+	const auto partialFilesPath = QStandardPaths::writableLocation( QStandardPaths::CacheLocation ) +
+								  QStringLiteral("/filetransfer");
+
+	QDir partialFilesDir( partialFilesPath );
+	partialFilesDir.mkpath( partialFilesPath );
+
+	// remove partial files of transfers which have not been resumed for a long time
+	const auto partialFiles = partialFilesDir.entryInfoList( { QStringLiteral("*.part") }, QDir::Files );
+	for( const auto& partialFile : partialFiles )
+	{
+		if( partialFile.lastModified().daysTo( QDateTime::currentDateTime() ) > PartialFileExpiryDays )
+		{
+			QFile::remove( partialFile.absoluteFilePath() );
+		}
+	}
+
+	return partialFilesDir.filePath( QString::fromLatin1( fileHash.toHex() ) + QStringLiteral(".part") );
+}
+
+
+
+void FileTransferPlugin::sendAcknowledgeMessage( VeyonWorkerInterface& worker, const QBitArray& presentChunks )
+{
+	FeatureMessage message( m_fileTransferFeature.uid(), FileTransferAcknowledgeCommand );
+	message.addArgument( TransferId, m_currentTransferId ).
+			addArgument( AcknowledgedChunks, m_receivedChunks );
+
+	if( presentChunks.isNull() == false )
+	{
+		message.addArgument( PresentChunks, presentChunks ).
+				addArgument( CompressionSupported, true );
+	}
+
+	worker.sendFeatureMessageReply( message );
+}
+
+
+
+void FileTransferPlugin::sendRejectMessage( VeyonWorkerInterface& worker, QUuid transferId )
+{
+	worker.sendFeatureMessageReply( FeatureMessage( m_fileTransferFeature.uid(), FileTransferRejectCommand ).
+									addArgument( TransferId, transferId ) );
+}
@@ -24,6 +24,7 @@
 
 #pragma once
 
+#include <QBitArray>
 #include <QFile>
 #include <QUrl>
 
@@ -31,6 +32,7 @@
 #include "FeatureProviderInterface.h"
 
 class FileTransferController;
+class FileWriteThread;
 class FileTransferUserConfiguration;
 
 class FileTransferPlugin : public QObject, FeatureProviderInterface, PluginInterface
@@ -93,9 +95,12 @@ public:
 
 	bool handleFeatureMessage( VeyonWorkerInterface& worker, const FeatureMessage& message ) override;
 
-	void sendStartMessage( QUuid transferId, const QString& fileName,
+	void sendStartMessage( QUuid transferId, const QString& fileName, bool packedFiles, qint64 fileSize, int chunkSize,
+						   const QByteArray& fileHash, const QByteArray& chunkHashes,
 						   bool overwriteExistingFile, const ComputerControlInterfaceList& interfaces );
-	void sendDataMessage( QUuid transferId, const QByteArray& data, const ComputerControlInterfaceList& interfaces );
+	// uncompressedSize is 0 for chunks which are not compressed
+	void sendDataMessage( QUuid transferId, int chunkIndex, const QByteArray& data, int uncompressedSize,
+						  const ComputerControlInterfaceList& interfaces );
 	void sendCancelMessage( QUuid transferId, const ComputerControlInterfaceList& interfaces );
 	void sendFinishMessage( QUuid transferId, const QString& fileName,
 							bool openFileInApplication, const ComputerControlInterfaceList& interfaces );
@@ -113,6 +118,18 @@ private:
 	void startFileTransfer( const QStringList& files, Configuration::Object* config,
 							const ComputerControlInterfaceList& interfaces );
 
+	void startTransfer( VeyonWorkerInterface& worker, const FeatureMessage& message );
+	bool receiveFile( VeyonWorkerInterface& worker, QUuid transferId, qint64 fileSize,
+					  const QBitArray& presentChunks );
+	void receiveChunk( VeyonWorkerInterface& worker, const FeatureMessage& message );
+	void finishTransfer( const FeatureMessage& message );
+	void cancelTransfer( bool removeFile );
+
+	static QString partialFileName( const QByteArray& fileHash );
+
+	void sendAcknowledgeMessage( VeyonWorkerInterface& worker, const QBitArray& presentChunks = {} );
+	void sendRejectMessage( VeyonWorkerInterface& worker, QUuid transferId );
+
 	enum Commands
 	{
 		FileTransferStartCommand,
@@ -120,6 +137,8 @@ private:
 		FileTransferCancelCommand,
 		FileTransferFinishCommand,
 		OpenTransferFolder,
+		FileTransferAcknowledgeCommand,
+		FileTransferRejectCommand,
 		CommandCount
 	};
 
@@ -130,9 +149,21 @@ private:
 		DataChunk,
 		OpenFileInApplication,
 		OverwriteExistingFile,
+		AcknowledgedChunks,
+		FileSize,
+		ChunkSize,
+		ChunkIndex,
+		FileHash,
+		ChunkHashes,
+		PresentChunks,
+		UncompressedSize,
+		CompressionSupported,
+		PackedFiles,
 		ArgumentsCount
 	};
 
+	static constexpr int PartialFileExpiryDays = 7;
+
 	const Feature m_fileTransferFeature;
 	const FeatureList m_features;
 
@@ -140,7 +171,22 @@ private:
 
 	FileTransferController* m_fileTransferController;
 
-	QFile m_currentFile;
+	// contexts of masters which started transfers, used for relaying acknowledgements from worker
+	QHash<QUuid, MessageContext> m_transferContexts;
+
+	FileWriteThread* m_fileWriteThread;
 	QUuid m_currentTransferId;
+	QString m_destinationFileName;
+	int m_chunkSize;
+	QByteArray m_fileHash;
+	QByteArray m_chunkHashes;
+	bool m_packedFiles;
+	bool m_overwriteExistingFiles;
+	bool m_transferComplete;
+	int m_receivedChunks;
+	qint64 m_writeOffset;
+	// chunks received while the partial file is still being prepared
+	bool m_preparingTransfer;
+	QList<FeatureMessage> m_pendingChunkMessages;
 
 };
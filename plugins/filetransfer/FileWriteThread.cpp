@@ -0,0 +1,292 @@
+/*
+ * FileWriteThread.cpp - implementation of FileWriteThread class
+ *
+ * Copyright (c) 2018-2019 Tobias Junghans <tobydox@veyon.io>
+ *
+ * This file is part of Veyon - https://veyon.io
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program (see COPYING); if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ *
+ */
+
+#include <algorithm>
+
+#include <QSemaphore>
+
+#ifdef Q_OS_WIN
+#include <io.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+#include "FileReadThread.h"
+#include "FileWriteThread.h"
+#include "VeyonCore.h"
+
+
+FileWriteThread::FileWriteThread( const QString& fileName, QObject* parent ) :
+	QObject( parent ),
+	m_mutex(),
+	m_pendingChunksWritten(),
+	m_thread( new QThread ),
+	m_file( nullptr ),
+	m_timer( new QTimer ),
+	m_fileName( fileName ),
+	m_pendingChunks(),
+	m_pendingBytes( 0 ),
+	m_writeError( false )
+{
+	m_timer->moveToThread( m_thread );
+	m_thread->start();
+
+	connect( m_thread, &QThread::finished, m_timer, &QObject::deleteLater );
+	connect( m_thread, &QThread::finished, m_thread, &QObject::deleteLater );
+}
+
+
+
+FileWriteThread::~FileWriteThread()
+{
+	m_thread->quit();
+	m_thread->wait();
+
+	delete m_file;
+}
+
+
+
+void FileWriteThread::prepare( const QString& existingFileName, bool reuseExistingFile, qint64 fileSize,
+								const QByteArray& fileHash, const QByteArray& chunkHashes, int chunkSize )
+{
+	// hashing and copying large files takes a while so do not block processing of incoming messages
+	QTimer::singleShot( 0, m_timer, [=]() {
+		const auto chunkCount = static_cast<int>( ( fileSize + chunkSize - 1 ) / chunkSize );
+
+		QFile existingFile( existingFileName );
+		if( existingFileName.isEmpty() == false && existingFile.size() == fileSize &&
+			existingFile.open( QFile::ReadOnly ) &&
+			FileReadThread::hashFile( existingFile, chunkSize ) == fileHash )
+		{
+			emit prepared( true, QBitArray( chunkCount, true ) );
+			return;
+		}
+
+		if( reuseExistingFile && QFile::exists( m_fileName ) == false && QFile::exists( existingFileName ) )
+		{
+			// reuse matching chunks of file to be overwritten
+			QFile::copy( existingFileName, m_fileName );
+		}
+
+		QByteArray existingChunkHashes;
+		QFile file( m_fileName );
+		if( file.open( QFile::ReadOnly ) )
+		{
+			FileReadThread::hashFile( file, chunkSize, &existingChunkHashes );
+		}
+
+		QBitArray presentChunks( chunkCount );
+		for( int i = 0; i < chunkCount && ( i + 1 ) * FileReadThread::HashSize <= existingChunkHashes.size(); ++i )
+		{
+			presentChunks.setBit( i, existingChunkHashes.mid( i * FileReadThread::HashSize, FileReadThread::HashSize ) ==
+								  chunkHashes.mid( i * FileReadThread::HashSize, FileReadThread::HashSize ) );
+		}
+
+		emit prepared( false, presentChunks );
+	} );
+}
+
+
+
+bool FileWriteThread::start( qint64 fileSize, bool truncate )
+{
+	const auto openMode = truncate ? QFile::WriteOnly | QFile::Truncate : QFile::ReadWrite;
+
+	if( QFile( m_fileName ).open( openMode ) == false )
+	{
+		return false;
+	}
+
+	// use timer living in writer thread as context so the file is accessed there only
+	QTimer::singleShot( 0, m_timer, [this, openMode, fileSize]() {
+		m_file = new QFile( m_fileName );
+		m_file->open( openMode );
+
+		if( fileSize > 0 )
+		{
+			// drop excess data of reused files and reserve space for the whole file up front
+			m_file->resize( fileSize );
+#ifdef Q_OS_LINUX
+			posix_fallocate( m_file->handle(), 0, fileSize );
+#endif
+		}
+	} );
+
+	return true;
+}
+
+
+
+void FileWriteThread::write( qint64 offset, const QByteArray& data )
+{
+	m_mutex.lock();
+
+	// block message processing only if the disk can't keep up at all
+	while( m_pendingBytes >= MaxPendingBytes )
+	{
+		m_pendingChunksWritten.wait( &m_mutex );
+	}
+
+	const auto writePending = m_pendingChunks.isEmpty() == false;
+
+	m_pendingChunks.append( { offset, data } );
+	m_pendingBytes += data.size();
+
+	m_mutex.unlock();
+
+	if( writePending == false )
+	{
+		QTimer::singleShot( 0, m_timer, [this]() { writePendingChunks(); } );
+	}
+}
+
+
+
+void FileWriteThread::finish( const QByteArray& expectedFileHash, int chunkSize )
+{
+	QTimer::singleShot( 0, m_timer, [this, expectedFileHash, chunkSize]() {
+		writePendingChunks();
+
+		auto success = m_file && m_writeError == false && syncFile();
+
+		if( success && expectedFileHash.isEmpty() == false &&
+			FileReadThread::hashFile( *m_file, chunkSize ) != expectedFileHash )
+		{
+			vCritical() << "checksum mismatch for received file" << m_fileName;
+			success = false;
+		}
+
+		if( m_file )
+		{
+			m_file->close();
+		}
+
+		emit finished( success );
+	} );
+}
+
+
+
+void FileWriteThread::cancel( bool removeFile )
+{
+	m_mutex.lock();
+	m_pendingChunks.clear();
+	m_pendingBytes = 0;
+	m_pendingChunksWritten.wakeAll();
+	m_mutex.unlock();
+
+	// wait for write in progress to complete and close file in writer thread
+	QSemaphore closed;
+	QTimer::singleShot( 0, m_timer, [this, &closed]() {
+		if( m_file )
+		{
+			m_file->close();
+		}
+		closed.release();
+	} );
+	closed.acquire();
+
+	if( removeFile )
+	{
+		QFile::remove( m_fileName );
+	}
+}
+
+
+
+void FileWriteThread::writePendingChunks()
+{
+	m_mutex.lock();
+	auto chunks = m_pendingChunks;
+	m_mutex.unlock();
+
+	if( chunks.isEmpty() || m_file == nullptr )
+	{
+		return;
+	}
+
+	std::sort( chunks.begin(), chunks.end(), []( const PendingChunk& a, const PendingChunk& b ) {
+		return a.offset < b.offset;
+	} );
+
+	// coalesce adjacent chunks into few large writes
+	qint64 writtenBytes = 0;
+	int i = 0;
+
+	while( i < chunks.count() )
+	{
+		const auto offset = chunks[i].offset;
+		auto buffer = chunks[i].data;
+
+		for( ++i; i < chunks.count() && chunks[i].offset == offset + buffer.size() &&
+			 buffer.size() + chunks[i].data.size() <= MaxWriteSize; ++i )
+		{
+			buffer.append( chunks[i].data );
+		}
+
+		if( m_file->seek( offset ) == false || m_file->write( buffer ) != buffer.size() )
+		{
+			vCritical() << "could not write to" << m_fileName << m_file->errorString();
+			m_writeError = true;
+		}
+
+		writtenBytes += buffer.size();
+	}
+
+	m_mutex.lock();
+	if( m_pendingChunks.count() >= chunks.count() )
+	{
+		m_pendingChunks.erase( m_pendingChunks.begin(), m_pendingChunks.begin() + chunks.count() );
+		m_pendingBytes -= writtenBytes;
+	}
+	const auto writePending = m_pendingChunks.isEmpty() == false;
+	m_pendingChunksWritten.wakeAll();
+	m_mutex.unlock();
+
+	emit chunksWritten( chunks.count() );
+
+	if( writePending )
+	{
+		writePendingChunks();
+	}
+}
+
+
+
+bool FileWriteThread::syncFile()
+{
+	if( m_file->flush() == false )
+	{
+		return false;
+	}
+
+	// make sure data is on disk before the file replaces the destination
+#ifdef Q_OS_WIN
+	return _commit( m_file->handle() ) == 0;
+#else
+	return fsync( m_file->handle() ) == 0;
+#endif
+}
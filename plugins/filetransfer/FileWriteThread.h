@@ -0,0 +1,85 @@
+/*
+ * FileWriteThread.h - declaration of FileWriteThread class
+ *
+ * Copyright (c) 2018-2019 Tobias Junghans <tobydox@veyon.io>
+ *
+ * This file is part of Veyon - https://veyon.io
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program (see COPYING); if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ *
+ */
+
+#pragma once
+
+#include <QBitArray>
+#include <QFile>
+#include <QMutex>
+#include <QTimer>
+#include <QThread>
+#include <QWaitCondition>
+
+// writes received chunks in background so slow disks do not block processing of incoming messages
+class FileWriteThread : public QObject
+{
+	Q_OBJECT
+public:
+	explicit FileWriteThread( const QString& fileName, QObject* parent = nullptr );
+	~FileWriteThread() override;
+
+	const QString& fileName() const
+	{
+		return m_fileName;
+	}
+
+	void prepare( const QString& existingFileName, bool reuseExistingFile, qint64 fileSize,
+				  const QByteArray& fileHash, const QByteArray& chunkHashes, int chunkSize );
+	bool start( qint64 fileSize, bool truncate );
+
+	void write( qint64 offset, const QByteArray& data );
+	void finish( const QByteArray& expectedFileHash, int chunkSize );
+	void cancel( bool removeFile );
+
+signals:
+	void prepared( bool identicalFile, const QBitArray& presentChunks );
+	void chunksWritten( int count );
+	void finished( bool success );
+
+private:
+	struct PendingChunk
+	{
+		qint64 offset;
+		QByteArray data;
+	};
+
+	void writePendingChunks();
+	bool syncFile();
+
+	static constexpr qint64 MaxPendingBytes = 8*1024*1024;
+	static constexpr int MaxWriteSize = 4*1024*1024;
+
+	QMutex m_mutex;
+	QWaitCondition m_pendingChunksWritten;
+	QThread* m_thread;
+	QFile* m_file;
+
+	QTimer* m_timer;
+
+	QString m_fileName;
+	QList<PendingChunk> m_pendingChunks;
+	qint64 m_pendingBytes;
+	bool m_writeError;
+
+};
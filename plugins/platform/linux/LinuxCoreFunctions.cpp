@@ -235,7 +235,8 @@ bool LinuxCoreFunctions::runProgramAsAdmin( const QString& program, const QStrin
 
 
 bool LinuxCoreFunctions::runProgramAsUser( const QString& program, const QStringList& parameters,
-										   const QString& username, const QString& desktop )
+										   const QString& username, const QString& desktop,
+										   const QProcessEnvironment& environment )
 {
 	Q_UNUSED(desktop)
 
@@ -268,6 +269,10 @@ bool LinuxCoreFunctions::runProgramAsUser( const QString& program, const QString
 
 	auto process = new UserProcess( uid );
 	process->connect( process, QOverload<int>::of( &QProcess::finished ), &QProcess::deleteLater );
+	if( environment.isEmpty() == false )
+	{
+		process->setProcessEnvironment( environment );
+	}
 	process->start( program, parameters );
 
 	return true;
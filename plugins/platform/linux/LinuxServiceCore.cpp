@@ -22,9 +22,9 @@
  *
  */
 
-#include <QDateTime>
 #include <QDBusReply>
 #include <QEventLoop>
+#include <QFileInfo>
 #include <QProcess>
 #include <QTimer>
 
@@ -42,6 +42,7 @@ LinuxServiceCore::LinuxServiceCore( QObject* parent ) :
 	m_dataManager()
 {
 	connectToLoginManager();
+	watchXDisplaySockets();
 }
 
 
@@ -49,12 +50,18 @@ LinuxServiceCore::LinuxServiceCore( QObject* parent ) :
 LinuxServiceCore::~LinuxServiceCore()
 {
 	stopAllServers();
+	stopSharedServer();
 }
 
 
 
 void LinuxServiceCore::run()
 {
+	if( sharedServer() )
+	{
+		startSharedServer();
+	}
+
 	const auto sessions = listSessions();
 
 	for( const auto& s : sessions )
@@ -70,19 +77,44 @@ void LinuxServiceCore::run()
 
 void LinuxServiceCore::startServer( const QString& login1SessionId, const QDBusObjectPath& sessionObjectPath )
 {
+	Q_UNUSED(login1SessionId)
+
 	const auto sessionPath = sessionObjectPath.path();
 
+	if( m_serverProcesses.contains( sessionPath ) || m_sharedServerSessions.contains( sessionPath ) )
+	{
+		stopWaitingForSession( sessionPath );
+		return;
+	}
+
 	const auto sessionType = getSessionType( sessionPath );
 
 	if( sessionType == QLatin1String("wayland") )
 	{
 		vCritical() << "Can't start Veyon Server in Wayland sessions as this is not yet supported. Please switch to X11-based sessions!";
+		stopWaitingForSession( sessionPath );
 		return;
 	}
 
 	// do not start server for non-graphical sessions
 	if( sessionType != QLatin1String("x11") )
 	{
+		stopWaitingForSession( sessionPath );
+		return;
+	}
+
+	const auto sessionState = getSessionState( sessionPath );
+	if( isSessionStarted( sessionState ) == false )
+	{
+		vDebug() << "Session" << sessionPath << "not yet started, state:" << sessionState;
+		waitForSession( sessionPath );
+		return;
+	}
+
+	if( isXDisplayAvailable( getSessionDisplay( sessionPath ) ) == false )
+	{
+		vDebug() << "X display of session" << sessionPath << "not yet available";
+		waitForSession( sessionPath );
 		return;
 	}
 
@@ -90,6 +122,7 @@ void LinuxServiceCore::startServer( const QString& login1SessionId, const QDBusO
 	if( sessionLeader < 0 )
 	{
 		vCritical() << "No leader available for session" << sessionPath;
+		stopWaitingForSession( sessionPath );
 		return;
 	}
 
@@ -97,31 +130,54 @@ void LinuxServiceCore::startServer( const QString& login1SessionId, const QDBusO
 
 	if( sessionEnvironment.isEmpty() )
 	{
+		// there's no notification mechanism for processes being spawned by the session
+		// leader, therefore fall back to probing once the session itself is ready
 		vWarning() << "Environment for session" << sessionPath << "not yet available - retrying in"
 				   << SessionEnvironmentProbingInterval << "msecs";
-		QTimer::singleShot( SessionEnvironmentProbingInterval, this,
-							[=]() { startServer( login1SessionId, sessionObjectPath ); } );
+		waitForSession( sessionPath );
+
+		if( m_environmentProbingSessions.contains( sessionPath ) == false )
+		{
+			m_environmentProbingSessions.insert( sessionPath );
+			QTimer::singleShot( SessionEnvironmentProbingInterval, this, [=]() {
+				m_environmentProbingSessions.remove( sessionPath );
+				if( m_pendingSessions.contains( sessionPath ) )
+				{
+					startServer( {}, sessionObjectPath );
+				}
+			} );
+		}
 		return;
 	}
 
+	stopWaitingForSession( sessionPath );
+
 	if( multiSession() == false && m_serverProcesses.isEmpty() == false )
 	{
 		// make sure no other server is still running
 		stopAllServers();
 	}
 
-	const auto sessionUptime = getSessionUptimeSeconds( sessionPath );
+	const auto seat = getSessionSeat( sessionPath );
+	const auto display = getSessionDisplay( sessionPath );
 
-	if( sessionUptime >= 0 && sessionUptime < SessionUptimeSecondsMinimum )
+	if( sharedServer() )
 	{
-		vDebug() << "Session" << sessionPath << "too young - retrying in" << SessionUptimeProbingInterval << "msecs";
-		QTimer::singleShot( SessionUptimeProbingInterval, this, [=]() { startServer( login1SessionId, sessionObjectPath ); } );
+		vInfo() << "Adding new session" << sessionPath
+				<< "with display" << display
+				<< "at seat" << seat.path << "to shared server";
+
+		const auto sessionId = openSession( QStringList( { sessionPath, display, seat.path } ) );
+		sessionEnvironment.insert( VeyonCore::sessionIdEnvironmentVariable(), QString::number( sessionId ) );
+
+		const SharedServerSession session{ sessionId, sessionEnvironment };
+		m_sharedServerSessions[sessionPath] = session;
+
+		sendSharedServerCommand( SharedServerCommand::OpenSession, session.id, session.environment );
+
 		return;
 	}
 
-	const auto seat = getSessionSeat( sessionPath );
-	const auto display = getSessionDisplay( sessionPath );
-
 	vInfo() << "Starting server for new session" << sessionPath
 			<< "with display" << display
 			<< "at seat" << seat.path;
@@ -150,7 +206,9 @@ void LinuxServiceCore::stopServer( const QString& login1SessionId, const QDBusOb
 
 	const auto sessionPath = sessionObjectPath.path();
 
-	if( m_serverProcesses.contains( sessionPath ) )
+	stopWaitingForSession( sessionPath );
+
+	if( m_serverProcesses.contains( sessionPath ) || m_sharedServerSessions.contains( sessionPath ) )
 	{
 		stopServer( sessionPath );
 	}
@@ -158,6 +216,18 @@ void LinuxServiceCore::stopServer( const QString& login1SessionId, const QDBusOb
 
 
 
+void LinuxServiceCore::handleSessionPropertiesChanged( const QDBusMessage& message )
+{
+	const auto sessionPath = message.path();
+
+	if( m_pendingSessions.contains( sessionPath ) )
+	{
+		startServer( {}, QDBusObjectPath( sessionPath ) );
+	}
+}
+
+
+
 void LinuxServiceCore::connectToLoginManager()
 {
 	bool success = true;
@@ -185,8 +255,92 @@ void LinuxServiceCore::connectToLoginManager()
 
 
 
+void LinuxServiceCore::watchXDisplaySockets()
+{
+	// QFileSystemWatcher is backed by inotify and notifies us as soon as an X server creates its socket
+	if( QFileInfo::exists( xDisplaySocketDirectory() ) )
+	{
+		m_xDisplaySocketWatcher.addPath( xDisplaySocketDirectory() );
+	}
+	else
+	{
+		// socket directory not yet created so watch its parent directory
+		m_xDisplaySocketWatcher.addPath( QFileInfo( xDisplaySocketDirectory() ).path() );
+	}
+
+	connect( &m_xDisplaySocketWatcher, &QFileSystemWatcher::directoryChanged, this, [this]() {
+		if( m_xDisplaySocketWatcher.directories().contains( xDisplaySocketDirectory() ) == false &&
+			QFileInfo::exists( xDisplaySocketDirectory() ) )
+		{
+			m_xDisplaySocketWatcher.addPath( xDisplaySocketDirectory() );
+			// changes in the parent directory are of no interest anymore
+			m_xDisplaySocketWatcher.removePath( QFileInfo( xDisplaySocketDirectory() ).path() );
+		}
+
+		startPendingSessionServers();
+	} );
+}
+
+
+
+void LinuxServiceCore::waitForSession( const QString& sessionPath )
+{
+	if( m_pendingSessions.contains( sessionPath ) )
+	{
+		return;
+	}
+
+	m_pendingSessions.insert( sessionPath );
+
+	if( QDBusConnection::systemBus().connect( m_loginManager->service(), sessionPath,
+											  QStringLiteral("org.freedesktop.DBus.Properties"),
+											  QStringLiteral("PropertiesChanged"),
+											  this, SLOT(handleSessionPropertiesChanged(QDBusMessage)) ) == false )
+	{
+		vWarning() << "could not subscribe to property changes of session" << sessionPath;
+	}
+}
+
+
+
+void LinuxServiceCore::stopWaitingForSession( const QString& sessionPath )
+{
+	if( m_pendingSessions.remove( sessionPath ) )
+	{
+		QDBusConnection::systemBus().disconnect( m_loginManager->service(), sessionPath,
+												 QStringLiteral("org.freedesktop.DBus.Properties"),
+												 QStringLiteral("PropertiesChanged"),
+												 this, SLOT(handleSessionPropertiesChanged(QDBusMessage)) );
+	}
+}
+
+
+
+void LinuxServiceCore::startPendingSessionServers()
+{
+	const auto pendingSessions = m_pendingSessions;
+
+	for( const auto& sessionPath : pendingSessions )
+	{
+		startServer( {}, QDBusObjectPath( sessionPath ) );
+	}
+}
+
+
+
 void LinuxServiceCore::stopServer( const QString& sessionPath )
 {
+	if( m_sharedServerSessions.contains( sessionPath ) )
+	{
+		vInfo() << "removing session" << sessionPath << "from shared server";
+
+		const auto session = m_sharedServerSessions.take( sessionPath );
+		sendSharedServerCommand( SharedServerCommand::CloseSession, session.id );
+		closeSession( session.id );
+
+		return;
+	}
+
 	if( m_serverProcesses.contains( sessionPath ) == false )
 	{
 		return;
@@ -221,6 +375,102 @@ void LinuxServiceCore::stopAllServers()
 	{
 		stopServer( m_serverProcesses.firstKey() );
 	}
+
+	while( m_sharedServerSessions.isEmpty() == false )
+	{
+		stopServer( m_sharedServerSessions.firstKey() );
+	}
+}
+
+
+
+void LinuxServiceCore::startSharedServer()
+{
+	auto environment = QProcessEnvironment::systemEnvironment();
+	environment.insert( QLatin1String( ServiceDataManager::serviceDataTokenEnvironmentVariable() ),
+						QString::fromUtf8( m_dataManager.token().toByteArray() ) );
+	// the shared server itself is not attached to any display
+	environment.insert( QStringLiteral("QT_QPA_PLATFORM"), QStringLiteral("offscreen") );
+
+	vInfo() << "Starting shared server";
+
+	m_sharedServerProcess = new QProcess( this );
+	m_sharedServerProcess->setProcessChannelMode( QProcess::ForwardedChannels );
+	m_sharedServerProcess->setProcessEnvironment( environment );
+
+	connect( m_sharedServerProcess, QOverload<int, QProcess::ExitStatus>::of( &QProcess::finished ),
+			 this, &LinuxServiceCore::handleSharedServerFinished );
+
+	m_sharedServerProcess->start( VeyonCore::filesystem().serverFilePath(), { sharedServerArgument() } );
+
+	// announce sessions which have been added while the shared server was not running
+	for( const auto& session : qAsConst(m_sharedServerSessions) )
+	{
+		sendSharedServerCommand( SharedServerCommand::OpenSession, session.id, session.environment );
+	}
+}
+
+
+
+void LinuxServiceCore::stopSharedServer()
+{
+	if( m_sharedServerProcess == nullptr )
+	{
+		return;
+	}
+
+	vInfo() << "stopping shared server";
+
+	auto process = m_sharedServerProcess;
+	m_sharedServerProcess = nullptr;
+
+	process->disconnect( this );
+
+	// closing the command channel makes the shared server quit
+	process->waitForBytesWritten( ServerTerminateTimeout );
+	process->closeWriteChannel();
+
+	if( process->waitForFinished( ServerTerminateTimeout ) == false )
+	{
+		process->terminate();
+
+		if( process->waitForFinished( ServerTerminateTimeout ) == false )
+		{
+			vWarning() << "shared server still running - killing now";
+			process->kill();
+			process->waitForFinished( ServerKillTimeout );
+		}
+	}
+
+	delete process;
+}
+
+
+
+void LinuxServiceCore::handleSharedServerFinished()
+{
+	vWarning() << "shared server finished unexpectedly - restarting in" << SharedServerRestartDelay << "msecs";
+
+	m_sharedServerProcess->deleteLater();
+	m_sharedServerProcess = nullptr;
+
+	QTimer::singleShot( SharedServerRestartDelay, this, [this]() {
+		if( m_sharedServerProcess == nullptr )
+		{
+			startSharedServer();
+		}
+	} );
+}
+
+
+
+void LinuxServiceCore::sendSharedServerCommand( SharedServerCommand command, SessionId sessionId,
+												const QProcessEnvironment& sessionEnvironment )
+{
+	if( m_sharedServerProcess )
+	{
+		m_sharedServerProcess->write( encodeSharedServerCommand( command, sessionId, sessionEnvironment ) );
+	}
 }
 
 
@@ -294,23 +544,16 @@ int LinuxServiceCore::getSessionLeaderPid( const QString& session )
 
 
 
-qint64 LinuxServiceCore::getSessionUptimeSeconds( const QString& session )
+QString LinuxServiceCore::getSessionType( const QString& session )
 {
-	const auto timestamp = getSessionProperty( session, QStringLiteral("Timestamp") );
-
-	if( timestamp.isNull() )
-	{
-		return -1;
-	}
-
-	return QDateTime::currentMSecsSinceEpoch() / 1000 - static_cast<qint64>( timestamp.toLongLong() / ( 1000 * 1000 ) );
+	return getSessionProperty( session, QStringLiteral("Type") ).toString();
 }
 
 
 
-QString LinuxServiceCore::getSessionType( const QString& session )
+QString LinuxServiceCore::getSessionState( const QString& session )
 {
-	return getSessionProperty( session, QStringLiteral("Type") ).toString();
+	return getSessionProperty( session, QStringLiteral("State") ).toString();
 }
 
 
@@ -374,3 +617,27 @@ QProcessEnvironment LinuxServiceCore::getSessionEnvironment( int sessionLeaderPi
 
 	return sessionEnv;
 }
+
+
+
+bool LinuxServiceCore::isSessionStarted( const QString& sessionState )
+{
+	return sessionState == QLatin1String("online") ||
+			sessionState == QLatin1String("active");
+}
+
+
+
+bool LinuxServiceCore::isXDisplayAvailable( const QString& display )
+{
+	// local displays are specified as ":<number>[.<screen>]"
+	if( display.startsWith( QLatin1Char(':') ) == false )
+	{
+		// remote display or unknown format - nothing to check
+		return true;
+	}
+
+	const auto displayNumber = display.mid( 1 ).section( QLatin1Char('.'), 0, 0 );
+
+	return QFileInfo::exists( xDisplaySocketDirectory() + QStringLiteral("/X") + displayNumber );
+}
@@ -24,7 +24,10 @@
 
 #pragma once
 
+#include <QDBusMessage>
+#include <QFileSystemWatcher>
 #include <QProcessEnvironment>
+#include <QSet>
 
 #include "LinuxCoreFunctions.h"
 #include "PlatformServiceCore.h"
@@ -44,6 +47,7 @@ public:
 private slots:
 	void startServer( const QString& login1SessionId, const QDBusObjectPath& sessionObjectPath );
 	void stopServer( const QString& login1SessionId, const QDBusObjectPath& sessionObjectPath );
+	void handleSessionPropertiesChanged( const QDBusMessage& message );
 
 private:
 	static constexpr auto LoginManagerReconnectInterval = 3000;
@@ -51,8 +55,7 @@ private:
 	static constexpr auto ServerKillTimeout = 10000;
 	static constexpr auto ServerWaitSleepInterval = 100;
 	static constexpr auto SessionEnvironmentProbingInterval = 1000;
-	static constexpr auto SessionUptimeSecondsMinimum = 3;
-	static constexpr auto SessionUptimeProbingInterval = 1000;
+	static constexpr auto SharedServerRestartDelay = 1000;
 
 	using LoginDBusSession = struct {
 		QString id;
@@ -67,26 +70,58 @@ private:
 		QString path;
 	} ;
 
+	struct SharedServerSession {
+		SessionId id;
+		QProcessEnvironment environment;
+	};
+
 	void connectToLoginManager();
+	void watchXDisplaySockets();
+
+	void waitForSession( const QString& sessionPath );
+	void stopWaitingForSession( const QString& sessionPath );
+	void startPendingSessionServers();
+
 	void stopServer( const QString& sessionPath );
 	void stopAllServers();
 
+	void startSharedServer();
+	void stopSharedServer();
+	void handleSharedServerFinished();
+	void sendSharedServerCommand( SharedServerCommand command, SessionId sessionId,
+								  const QProcessEnvironment& sessionEnvironment = {} );
+
 	QStringList listSessions();
 
 	static QVariant getSessionProperty( const QString& session, const QString& property );
 
 	static int getSessionLeaderPid( const QString& session );
-	static qint64 getSessionUptimeSeconds( const QString& session );
 	static QString getSessionType( const QString& session );
+	static QString getSessionState( const QString& session );
 	static QString getSessionDisplay( const QString& session );
 	static QString getSessionId( const QString& session );
 	static LoginDBusSessionSeat getSessionSeat( const QString& session );
 
 	static QProcessEnvironment getSessionEnvironment( int sessionLeaderPid );
 
+	static bool isSessionStarted( const QString& sessionState );
+	static bool isXDisplayAvailable( const QString& display );
+
+	static QString xDisplaySocketDirectory()
+	{
+		return QStringLiteral("/tmp/.X11-unix");
+	}
+
 	LinuxCoreFunctions::DBusInterfacePointer m_loginManager;
 	QMap<QString, QProcess *> m_serverProcesses;
 
+	QSet<QString> m_pendingSessions;
+	QSet<QString> m_environmentProbingSessions;
+	QFileSystemWatcher m_xDisplaySocketWatcher;
+
+	QProcess* m_sharedServerProcess{nullptr};
+	QMap<QString, SharedServerSession> m_sharedServerSessions;
+
 	ServiceDataManager m_dataManager;
 
 };
@@ -324,8 +324,12 @@ bool WindowsCoreFunctions::runProgramAsAdmin( const QString& program, const QStr
 bool WindowsCoreFunctions::runProgramAsUser( const QString& program,
 											 const QStringList& parameters,
 											 const QString& username,
-											 const QString& desktop )
+											 const QString& desktop,
+											 const QProcessEnvironment& environment )
 {
+	// processes are always started with the environment of the user session on Windows
+	Q_UNUSED(environment)
+
 	vDebug() << program << parameters << username << desktop;
 
 	const auto baseProcessId = WtsSessionManager::findUserProcessId( username );
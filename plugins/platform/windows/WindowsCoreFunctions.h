@@ -63,7 +63,8 @@ public:
 	bool runProgramAsUser( const QString& program,
 						   const QStringList& parameters,
 						   const QString& username,
-						   const QString& desktop ) override;
+						   const QString& desktop,
+						   const QProcessEnvironment& environment = {} ) override;
 
 	QString genericUrlHandler() const override;
 
@@ -41,7 +41,8 @@ ComputerControlClient::ComputerControlClient( ComputerControlServer* server,
 					  &m_serverClient,
 					  server->authenticationManager(),
 					  server->accessControlManager() ),
-	m_clientProtocol( vncServerSocket(), vncServerPassword )
+	m_clientProtocol( vncServerSocket(), vncServerPassword ),
+	m_featureMessageWireFormat( FeatureMessage::WireFormat::Legacy )
 {
 	m_serverProtocol.start();
 	m_clientProtocol.start();
@@ -68,7 +69,7 @@ bool ComputerControlClient::receiveClientMessage()
 
 	if( messageType == FeatureMessage::RfbMessageType )
 	{
-		return m_server->handleFeatureMessage( socket );
+		return m_server->handleFeatureMessage( socket, m_featureMessageWireFormat );
 	}
 
 	return VncProxyConnection::receiveClientMessage();
@@ -24,6 +24,7 @@
 
 #pragma once
 
+#include "FeatureMessage.h"
 #include "VncClientProtocol.h"
 #include "VncProxyConnection.h"
 #include "VncServerClient.h"
@@ -65,4 +66,6 @@ private:
 	VeyonServerProtocol m_serverProtocol;
 	VncClientProtocol m_clientProtocol;
 
+	FeatureMessage::WireFormat m_featureMessageWireFormat;
+
 } ;
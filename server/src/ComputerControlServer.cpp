@@ -23,6 +23,7 @@
  */
 
 #include <QCoreApplication>
+#include <QTimer>
 
 #include "AccessControlProvider.h"
 #include "BuiltinFeatures.h"
@@ -35,28 +36,42 @@
 
 
 ComputerControlServer::ComputerControlServer( QObject* parent ) :
+	ComputerControlServer( VeyonCore::sessionId(), {}, parent )
+{
+}
+
+
+
+ComputerControlServer::ComputerControlServer( int sessionId, const QProcessEnvironment& sessionEnvironment,
+											  QObject* parent ) :
 	QObject( parent ),
+	m_sessionId( sessionId ),
+	m_sessionEnvironment( sessionEnvironment ),
+	m_sessionUser( sessionEnvironment.value( QStringLiteral("USER") ) ),
 	m_allowedIPs(),
 	m_failedAuthHosts(),
 	m_featureManager(),
 	m_featureWorkerManager( *this, m_featureManager ),
 	m_serverAuthenticationManager( this ),
-	m_serverAccessControlManager( m_featureWorkerManager, VeyonCore::builtinFeatures().desktopAccessDialog(), this ),
-	m_vncServer(),
-	m_vncProxyServer( VeyonCore::config().localConnectOnly() || AccessControlProvider().isAccessToLocalComputerDenied() ?
+	m_serverAccessControlManager( m_featureWorkerManager, VeyonCore::builtinFeatures().desktopAccessDialog(),
+								  m_sessionUser, this ),
+	m_vncServer( sessionId, sessionEnvironment ),
+	m_vncProxyServer( VeyonCore::config().localConnectOnly() ||
+					  AccessControlProvider().isAccessToLocalComputerDenied( m_sessionUser ) ?
 						  QHostAddress::LocalHost : QHostAddress::Any,
-					  VeyonCore::config().primaryServicePort() + VeyonCore::sessionId(),
+					  VeyonCore::config().primaryServicePort() + m_sessionId,
 					  this,
 					  this )
 {
 	VeyonCore::builtinFeatures().systemTrayIcon().setToolTip(
 				tr( "%1 Service %2 at %3:%4" ).arg( VeyonCore::applicationName(), VeyonCore::versionString(),
 													HostAddress::localFQDN(),
-													QString::number( VeyonCore::config().primaryServicePort() + VeyonCore::sessionId() ) ),
+													QString::number( VeyonCore::config().primaryServicePort() + m_sessionId ) ),
 				m_featureWorkerManager );
 
-	// make app terminate once the VNC server thread has finished
-	connect( &m_vncServer, &VncServer::finished, QCoreApplication::instance(), &QCoreApplication::quit );
+	// make app terminate once the VNC server thread has finished unless serving
+	// one of multiple sessions in which case the VNC server helper is restarted
+	connect( &m_vncServer, &VncServer::finished, this, &ComputerControlServer::handleVncServerFinished );
 
 	connect( &m_serverAuthenticationManager, &ServerAuthenticationManager::finished,
 			 this, &ComputerControlServer::showAuthenticationMessage );
@@ -101,7 +116,7 @@ VncProxyConnection* ComputerControlServer::createVncProxyConnection( QTcpSocket*
 
 
 
-bool ComputerControlServer::handleFeatureMessage( QTcpSocket* socket )
+bool ComputerControlServer::handleFeatureMessage( QTcpSocket* socket, FeatureMessage::WireFormat& wireFormat )
 {
 	char messageType;
 	if( socket->getChar( &messageType ) == false )
@@ -120,7 +135,31 @@ bool ComputerControlServer::handleFeatureMessage( QTcpSocket* socket )
 
 	featureMessage.receive( socket );
 
-	return m_featureManager.handleFeatureMessage( *this, MessageContext( socket ), featureMessage );
+	if( featureMessage.isWireFormatNegotiation() )
+	{
+		wireFormat = FeatureMessage::negotiatedWireFormat( featureMessage );
+
+		vDebug() << "using feature message wire format" << static_cast<int>( wireFormat );
+
+		// confirm in legacy format as the client does not know about the result yet
+		return sendFeatureMessageReply( MessageContext( socket ),
+										FeatureMessage( featureMessage.featureUid(), FeatureMessage::NegotiateWireFormatCommand )
+											.addWireFormatArgument( wireFormat ) );
+	}
+
+	return m_featureManager.handleFeatureMessage( *this, MessageContext( socket, wireFormat ), featureMessage );
+}
+
+
+
+QProcessEnvironment ComputerControlServer::sessionEnvironment() const
+{
+	if( isHosted() )
+	{
+		return m_sessionEnvironment;
+	}
+
+	return QProcessEnvironment::systemEnvironment();
 }
 
 
@@ -132,7 +171,23 @@ bool ComputerControlServer::sendFeatureMessageReply( const MessageContext& conte
 	char rfbMessageType = FeatureMessage::RfbMessageType;
 	context.ioDevice()->write( &rfbMessageType, sizeof(rfbMessageType) );
 
-	return reply.send( context.ioDevice() );
+	return reply.send( context.ioDevice(), context.wireFormat() );
+}
+
+
+
+void ComputerControlServer::handleVncServerFinished()
+{
+	if( isHosted() == false )
+	{
+		QCoreApplication::quit();
+	}
+	else if( m_vncServer.isInterruptionRequested() == false )
+	{
+		vWarning() << "VNC server for session" << m_sessionId << "finished - restarting in"
+				   << VncServerRestartDelay << "msecs";
+		QTimer::singleShot( VncServerRestartDelay, &m_vncServer, [this]() { m_vncServer.start(); } );
+	}
 }
 
 
@@ -25,6 +25,7 @@
 #pragma once
 
 #include <QtCore/QMutex>
+#include <QtCore/QProcessEnvironment>
 #include <QtCore/QStringList>
 
 #include "FeatureManager.h"
@@ -40,7 +41,10 @@ class ComputerControlServer : public QObject, VncProxyConnectionFactory, VeyonSe
 {
 	Q_OBJECT
 public:
+	using Password = CryptoCore::PlaintextPassword;
+
 	explicit ComputerControlServer( QObject* parent = nullptr );
+	ComputerControlServer( int sessionId, const QProcessEnvironment& sessionEnvironment, QObject* parent = nullptr );
 	~ComputerControlServer() override;
 
 	bool start();
@@ -60,7 +64,7 @@ public:
 		return m_serverAccessControlManager;
 	}
 
-	bool handleFeatureMessage( QTcpSocket* socket );
+	bool handleFeatureMessage( QTcpSocket* socket, FeatureMessage::WireFormat& wireFormat );
 
 	bool sendFeatureMessageReply( const MessageContext& context, const FeatureMessage& reply ) override;
 
@@ -69,11 +73,46 @@ public:
 		return m_featureWorkerManager;
 	}
 
+	int sessionId() const override
+	{
+		return m_sessionId;
+	}
+
+	QString sessionUser() const override
+	{
+		return m_sessionUser;
+	}
+
+	QProcessEnvironment sessionEnvironment() const override;
+
+	int vncServerPort() const override
+	{
+		return m_vncServer.serverPort();
+	}
+
+	Password vncServerPassword() const override
+	{
+		return m_vncServer.password();
+	}
+
 
 private:
+	static constexpr auto VncServerRestartDelay = 1000;
+
+	bool isHosted() const
+	{
+		return m_sessionEnvironment.isEmpty() == false;
+	}
+
+	void handleVncServerFinished();
+
 	void showAuthenticationMessage( VncServerClient* client );
 	void showAccessControlMessage( VncServerClient* client );
 
+	const int m_sessionId;
+	const QProcessEnvironment m_sessionEnvironment;
+	const QString m_sessionUser;
+
 	QMutex m_dataMutex;
 	QStringList m_allowedIPs;
 
@@ -0,0 +1,130 @@
+/*
+ * MultiSessionServer.cpp - implementation of MultiSessionServer
+ *
+ * Copyright (c) 2019 Tobias Junghans <tobydox@veyon.io>
+ *
+ * This file is part of Veyon - https://veyon.io
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program (see COPYING); if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ *
+ */
+
+#include <QCoreApplication>
+#include <QSocketNotifier>
+
+#include "ComputerControlServer.h"
+#include "MultiSessionServer.h"
+#include "PlatformServiceCore.h"
+
+
+MultiSessionServer::MultiSessionServer( QObject* parent ) :
+	QObject( parent )
+{
+}
+
+
+
+MultiSessionServer::~MultiSessionServer()
+{
+	while( m_servers.isEmpty() == false )
+	{
+		closeSession( m_servers.firstKey() );
+	}
+}
+
+
+
+bool MultiSessionServer::start()
+{
+	// read unbuffered so the socket notifier fires for every command not yet processed
+	if( m_input.open( stdin, QFile::ReadOnly | QFile::Unbuffered ) == false )
+	{
+		vCritical() << "could not open command channel";
+		return false;
+	}
+
+	m_inputNotifier = new QSocketNotifier( m_input.handle(), QSocketNotifier::Read, this );
+	connect( m_inputNotifier, &QSocketNotifier::activated, this, &MultiSessionServer::readCommands );
+
+	return true;
+}
+
+
+
+void MultiSessionServer::readCommands()
+{
+	const auto line = m_input.readLine();
+	if( line.isEmpty() )
+	{
+		vInfo() << "command channel closed - exiting";
+		m_inputNotifier->setEnabled( false );
+		QCoreApplication::quit();
+		return;
+	}
+
+	PlatformServiceCore::SessionId sessionId = PlatformServiceCore::SessionIdInvalid;
+	QProcessEnvironment sessionEnvironment;
+
+	switch( PlatformServiceCore::decodeSharedServerCommand( line, sessionId, sessionEnvironment ) )
+	{
+	case PlatformServiceCore::SharedServerCommand::OpenSession:
+		openSession( sessionId, sessionEnvironment );
+		break;
+	case PlatformServiceCore::SharedServerCommand::CloseSession:
+		closeSession( sessionId );
+		break;
+	default:
+		vWarning() << "invalid command" << line;
+		break;
+	}
+}
+
+
+
+void MultiSessionServer::openSession( int sessionId, const QProcessEnvironment& sessionEnvironment )
+{
+	if( sessionId == PlatformServiceCore::SessionIdInvalid || sessionEnvironment.isEmpty() )
+	{
+		vWarning() << "invalid session" << sessionId;
+		return;
+	}
+
+	closeSession( sessionId );
+
+	vInfo() << "serving session" << sessionId << "of user" << sessionEnvironment.value( QStringLiteral("USER") );
+
+	auto server = new ComputerControlServer( sessionId, sessionEnvironment, this );
+	if( server->start() == false )
+	{
+		vCritical() << "failed to start server for session" << sessionId;
+		delete server;
+		return;
+	}
+
+	m_servers[sessionId] = server;
+}
+
+
+
+void MultiSessionServer::closeSession( int sessionId )
+{
+	const auto server = m_servers.take( sessionId );
+	if( server )
+	{
+		vInfo() << "stopped serving session" << sessionId;
+		delete server;
+	}
+}
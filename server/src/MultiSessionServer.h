@@ -0,0 +1,56 @@
+/*
+ * MultiSessionServer.h - header file for MultiSessionServer
+ *
+ * Copyright (c) 2019 Tobias Junghans <tobydox@veyon.io>
+ *
+ * This file is part of Veyon - https://veyon.io
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program (see COPYING); if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ *
+ */
+
+#pragma once
+
+#include <QFile>
+#include <QMap>
+#include <QProcessEnvironment>
+
+class QSocketNotifier;
+class ComputerControlServer;
+
+// serves all sessions announced by the service through stdin within a single process
+// while the VNC server of each session runs in a lightweight helper process
+class MultiSessionServer : public QObject
+{
+	Q_OBJECT
+public:
+	explicit MultiSessionServer( QObject* parent = nullptr );
+	~MultiSessionServer() override;
+
+	bool start();
+
+private:
+	void readCommands();
+
+	void openSession( int sessionId, const QProcessEnvironment& sessionEnvironment );
+	void closeSession( int sessionId );
+
+	QFile m_input;
+	QSocketNotifier* m_inputNotifier{nullptr};
+
+	QMap<int, ComputerControlServer *> m_servers;
+
+} ;
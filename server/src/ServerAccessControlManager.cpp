@@ -31,10 +31,12 @@
 
 ServerAccessControlManager::ServerAccessControlManager( FeatureWorkerManager& featureWorkerManager,
 														DesktopAccessDialog& desktopAccessDialog,
+														const QString& localUser,
 														QObject* parent ) :
 	QObject( parent ),
 	m_featureWorkerManager( featureWorkerManager ),
 	m_desktopAccessDialog( desktopAccessDialog ),
+	m_localUser( localUser ),
 	m_clients(),
 	m_desktopAccessChoices()
 {
@@ -118,7 +120,8 @@ void ServerAccessControlManager::performAccessControl( VncServerClient* client )
 	const auto accessResult =
 			AccessControlProvider().checkAccess( client->username(),
 												 client->hostAddress(),
-												 connectedUsers() );
+												 connectedUsers(),
+												 m_localUser );
 
 	switch( accessResult )
 	{
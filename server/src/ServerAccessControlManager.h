@@ -35,6 +35,7 @@ class ServerAccessControlManager : public QObject
 public:
 	ServerAccessControlManager( FeatureWorkerManager& featureWorkerManager,
 								DesktopAccessDialog& desktopAccessDialog,
+								const QString& localUser,
 								QObject* parent );
 
 	void addClient( VncServerClient* client );
@@ -55,6 +56,7 @@ private:
 
 	FeatureWorkerManager& m_featureWorkerManager;
 	DesktopAccessDialog& m_desktopAccessDialog;
+	const QString m_localUser;
 
 	VncServerClientList m_clients;
 
@@ -23,10 +23,15 @@
  *
  */
 
+#include <QCoreApplication>
+#include <QFile>
+#include <QProcess>
+
 #include "rfb/rfbproto.h"
 
 #include "AuthenticationCredentials.h"
 #include "CryptoCore.h"
+#include "Filesystem.h"
 #include "VeyonConfiguration.h"
 #include "PluginManager.h"
 #include "VncServer.h"
@@ -34,12 +39,20 @@
 
 
 VncServer::VncServer( QObject* parent ) :
-	QThread( parent ),
-	m_pluginInterface( nullptr )
+	VncServer( VeyonCore::sessionId(), {}, parent )
 {
-	VeyonCore::authenticationCredentials().setInternalVncServerPassword(
-				CryptoCore::generateChallenge().toBase64().left( MAXPWLEN ) );
+	VeyonCore::authenticationCredentials().setInternalVncServerPassword( m_password );
+}
 
+
+
+VncServer::VncServer( int sessionId, const QProcessEnvironment& sessionEnvironment, QObject* parent ) :
+	QThread( parent ),
+	m_pluginInterface( nullptr ),
+	m_sessionId( sessionId ),
+	m_sessionEnvironment( sessionEnvironment ),
+	m_password( CryptoCore::generateChallenge().toBase64().left( MAXPWLEN ) )
+{
 	VncServerPluginInterfaceList defaultVncServerPlugins;
 
 	for( auto pluginObject : qAsConst( VeyonCore::pluginManager().pluginObjects() ) )
@@ -78,6 +91,12 @@ VncServer::VncServer( QObject* parent ) :
 VncServer::~VncServer()
 {
 	vDebug();
+
+	if( isHosted() )
+	{
+		requestInterruption();
+		wait();
+	}
 }
 
 
@@ -98,10 +117,10 @@ int VncServer::serverPort() const
 {
 	if( m_pluginInterface && m_pluginInterface->configuredServerPort() > 0 )
 	{
-		return m_pluginInterface->configuredServerPort() + VeyonCore::sessionId();
+		return m_pluginInterface->configuredServerPort() + m_sessionId;
 	}
 
-	return VeyonCore::config().vncServerPort() + VeyonCore::sessionId();
+	return VeyonCore::config().vncServerPort() + m_sessionId;
 }
 
 
@@ -113,14 +132,51 @@ VncServer::Password VncServer::password() const
 		return m_pluginInterface->configuredPassword();
 	}
 
-	return VeyonCore::authenticationCredentials().internalVncServerPassword();
+	return m_password;
+}
+
+
+
+/*!
+ * \brief Runs the VNC server in the current process on behalf of a server process serving multiple
+ * sessions - the password is read from stdin so it does not show up in the process environment
+ */
+bool VncServer::runAsHelper()
+{
+	QFile input;
+	if( input.open( stdin, QFile::ReadOnly | QFile::Unbuffered ) == false )
+	{
+		vCritical() << "could not open input channel";
+		return false;
+	}
+
+	const auto password = input.readLine().trimmed();
+	if( password.isEmpty() )
+	{
+		vCritical() << "no password received";
+		return false;
+	}
+
+	m_password = password;
+	VeyonCore::authenticationCredentials().setInternalVncServerPassword( m_password );
+
+	connect( this, &VncServer::finished, QCoreApplication::instance(), &QCoreApplication::quit );
+
+	prepare();
+	start();
+
+	return true;
 }
 
 
 
 void VncServer::run()
 {
-	if( m_pluginInterface )
+	if( isHosted() )
+	{
+		runHelperProcess();
+	}
+	else if( m_pluginInterface )
 	{
 		vDebug() << "running";
 
@@ -139,3 +195,41 @@ void VncServer::run()
 		vDebug() << "finished";
 	}
 }
+
+
+
+void VncServer::runHelperProcess()
+{
+	QProcess helper;
+	helper.setProcessChannelMode( QProcess::ForwardedChannels );
+	helper.setProcessEnvironment( m_sessionEnvironment );
+	helper.start( VeyonCore::filesystem().serverFilePath(), { helperArgument() } );
+
+	if( helper.waitForStarted() == false )
+	{
+		vCritical() << "could not start VNC server helper for session" << m_sessionId << helper.errorString();
+		return;
+	}
+
+	helper.write( password().toByteArray() + '\n' );
+	helper.closeWriteChannel();
+
+	vDebug() << "running helper for session" << m_sessionId;
+
+	while( helper.waitForFinished( HelperPollInterval ) == false &&
+		   helper.state() != QProcess::NotRunning )
+	{
+		if( isInterruptionRequested() )
+		{
+			helper.terminate();
+			if( helper.waitForFinished( HelperTerminateTimeout ) == false )
+			{
+				helper.kill();
+				helper.waitForFinished();
+			}
+			break;
+		}
+	}
+
+	vDebug() << "helper for session" << m_sessionId << "finished";
+}
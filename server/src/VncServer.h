@@ -25,6 +25,7 @@
 
 #pragma once
 
+#include <QProcessEnvironment>
 #include <QThread>
 
 #include "CryptoCore.h"
@@ -38,6 +39,7 @@ public:
 	using Password = CryptoCore::PlaintextPassword;
 
 	explicit VncServer( QObject* parent = nullptr );
+	VncServer( int sessionId, const QProcessEnvironment& sessionEnvironment, QObject* parent = nullptr );
 	~VncServer() override;
 
 	void prepare();
@@ -46,9 +48,28 @@ public:
 
 	Password password() const;
 
+	bool runAsHelper();
+
+	static QString helperArgument()
+	{
+		return QStringLiteral("--vnc-server-helper");
+	}
+
 private:
+	static constexpr auto HelperPollInterval = 100;
+	static constexpr auto HelperTerminateTimeout = 3000;
+
 	void run() override;
+	void runHelperProcess();
+
+	bool isHosted() const
+	{
+		return m_sessionEnvironment.isEmpty() == false;
+	}
 
 	VncServerPluginInterface* m_pluginInterface;
+	int m_sessionId;
+	QProcessEnvironment m_sessionEnvironment;
+	Password m_password;
 
 } ;
@@ -25,6 +25,8 @@
 #include <QGuiApplication>
 
 #include "ComputerControlServer.h"
+#include "MultiSessionServer.h"
+#include "PlatformServiceCore.h"
 #include "VeyonConfiguration.h"
 
 
@@ -33,8 +35,35 @@ int main( int argc, char **argv )
 	QGuiApplication::setAttribute( Qt::AA_EnableHighDpiScaling );
 	QGuiApplication app( argc, argv );
 
+	const auto arguments = QCoreApplication::arguments();
+
+	if( arguments.contains( VncServer::helperArgument() ) )
+	{
+		VeyonCore core( &app, VeyonCore::Component::Server, QStringLiteral("VncServer") );
+
+		VncServer vncServer;
+		if( vncServer.runAsHelper() == false )
+		{
+			return -1;
+		}
+
+		return core.exec();
+	}
+
 	VeyonCore core( &app, VeyonCore::Component::Server, QStringLiteral("Server") );
 
+	if( arguments.contains( PlatformServiceCore::sharedServerArgument() ) )
+	{
+		MultiSessionServer server( &core );
+		if( server.start() == false )
+		{
+			vCritical() << "Failed to start multi session server";
+			return -1;
+		}
+
+		return core.exec();
+	}
+
 	ComputerControlServer server( &core );
 	if( server.start() == false )
 	{
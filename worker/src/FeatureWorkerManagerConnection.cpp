@@ -23,9 +23,9 @@
  */
 
 #include <QCoreApplication>
-#include <QHostAddress>
 
 #include "FeatureManager.h"
+#include "FeatureWorkerManager.h"
 #include "FeatureWorkerManagerConnection.h"
 #include "VeyonConfiguration.h"
 
@@ -38,26 +38,26 @@ FeatureWorkerManagerConnection::FeatureWorkerManagerConnection( VeyonWorkerInter
 	m_worker( worker ),
 	m_featureManager( featureManager ),
 	m_socket( this ),
-	m_featureUid( featureUid )
+	m_featureUid( featureUid ),
+	m_wireFormat( FeatureMessage::WireFormat::Legacy )
 {
-	connect( &m_socket, &QTcpSocket::connected,
+	connect( &m_socket, &QLocalSocket::connected,
 			 this, &FeatureWorkerManagerConnection::sendInitMessage );
 
-	connect( &m_socket, &QTcpSocket::disconnected,
+	connect( &m_socket, &QLocalSocket::disconnected,
 			 QCoreApplication::instance(), &QCoreApplication::quit );
 
-	connect( &m_socket, &QTcpSocket::readyRead,
+	connect( &m_socket, &QLocalSocket::readyRead,
 			 this, &FeatureWorkerManagerConnection::receiveMessage );
 
-	m_socket.connectToHost( QHostAddress::LocalHost,
-							static_cast<quint16>( VeyonCore::config().featureWorkerManagerPort() + VeyonCore::sessionId() ) );
+	m_socket.connectToServer( FeatureWorkerManager::serverName( VeyonCore::sessionId() ) );
 }
 
 
 
 bool FeatureWorkerManagerConnection::sendMessage( const FeatureMessage& message )
 {
-	return message.send( &m_socket );
+	return message.send( &m_socket, m_wireFormat );
 }
 
 
@@ -66,7 +66,18 @@ void FeatureWorkerManagerConnection::sendInitMessage()
 {
 	vDebug() << m_featureUid;
 
-	FeatureMessage( m_featureUid, FeatureMessage::InitCommand ).send( &m_socket );
+	// announce supported wire format - the manager confirms it with a negotiation message
+	FeatureMessage initMessage( m_featureUid, FeatureMessage::InitCommand );
+	initMessage.addWireFormatArgument();
+
+	if( m_featureUid.isNull() )
+	{
+		// pooled worker waiting for a feature to be assigned
+		initMessage.addArgument( FeatureWorkerManager::PooledWorkerArgument::ProcessId,
+								 QCoreApplication::applicationPid() );
+	}
+
+	initMessage.send( &m_socket, m_wireFormat );
 }
 
 
@@ -77,7 +88,24 @@ void FeatureWorkerManagerConnection::receiveMessage()
 
 	while( featureMessage.isReadyForReceive( &m_socket ) )
 	{
-		if( featureMessage.receive( &m_socket ) )
+		if( featureMessage.receive( &m_socket ) == false )
+		{
+			continue;
+		}
+
+		if( featureMessage.isWireFormatNegotiation() )
+		{
+			m_wireFormat = FeatureMessage::negotiatedWireFormat( featureMessage );
+		}
+		else if( featureMessage.command() == FeatureMessage::AssignFeatureCommand && m_featureUid.isNull() )
+		{
+			m_featureUid = featureMessage.featureUid();
+
+			emit featureAssigned( m_featureUid );
+
+			sendInitMessage();
+		}
+		else
 		{
 			m_featureManager.handleFeatureMessage( m_worker, featureMessage );
 		}
@@ -24,12 +24,11 @@
 
 #pragma once
 
-#include <QTcpSocket>
+#include <QLocalSocket>
 
-#include "Feature.h"
+#include "FeatureMessage.h"
 
 class FeatureManager;
-class FeatureMessage;
 class VeyonWorkerInterface;
 
 class FeatureWorkerManagerConnection : public QObject
@@ -44,13 +43,17 @@ public:
 
 	bool sendMessage( const FeatureMessage& message );
 
+signals:
+	void featureAssigned( Feature::Uid featureUid );
+
 private:
 	void sendInitMessage();
 	void receiveMessage();
 
 	VeyonWorkerInterface& m_worker;
 	FeatureManager& m_featureManager;
-	QTcpSocket m_socket;
+	QLocalSocket m_socket;
 	Feature::Uid m_featureUid;
+	FeatureMessage::WireFormat m_wireFormat;
 
 } ;
@@ -33,9 +33,32 @@ VeyonWorker::VeyonWorker( const QString& featureUid, QObject* parent ) :
 	QObject( parent ),
 	m_core( QCoreApplication::instance(),
 			VeyonCore::Component::Worker,
-			QStringLiteral( "FeatureWorker-" ) + VeyonCore::formattedUuid( featureUid ) ),
+			featureUid.isEmpty() ? QStringLiteral( "FeatureWorker-Pooled" )
+								 : QStringLiteral( "FeatureWorker-" ) + VeyonCore::formattedUuid( featureUid ) ),
 	m_featureManager(),
 	m_workerManagerConnection( nullptr )
+{
+	if( featureUid.isEmpty() == false )
+	{
+		initFeature( featureUid );
+	}
+
+	m_workerManagerConnection = new FeatureWorkerManagerConnection( *this, m_featureManager, featureUid, this );
+
+	connect( m_workerManagerConnection, &FeatureWorkerManagerConnection::featureAssigned,
+			 this, [this]( Feature::Uid featureUid ) { initFeature( featureUid.toString() ); } );
+}
+
+
+
+bool VeyonWorker::sendFeatureMessageReply( const FeatureMessage& reply )
+{
+	return m_workerManagerConnection->sendMessage( reply );
+}
+
+
+
+void VeyonWorker::initFeature( const QString& featureUid )
 {
 	const Feature* workerFeature = nullptr;
 
@@ -57,14 +80,5 @@ VeyonWorker::VeyonWorker( const QString& featureUid, QObject* parent ) :
 		qFatal( "Specified feature is disabled by configuration!" );
 	}
 
-	m_workerManagerConnection = new FeatureWorkerManagerConnection( *this, m_featureManager, featureUid, this );
-
 	vInfo() << "Running worker for feature" << workerFeature->name();
 }
-
-
-
-bool VeyonWorker::sendFeatureMessageReply( const FeatureMessage& reply )
-{
-	return m_workerManagerConnection->sendMessage( reply );
-}
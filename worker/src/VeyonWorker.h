@@ -43,6 +43,8 @@ public:
 	}
 
 private:
+	void initFeature( const QString& featureUid );
+
 	VeyonCore m_core;
 	FeatureManager m_featureManager;
 	FeatureWorkerManagerConnection* m_workerManagerConnection;
@@ -24,6 +24,7 @@
 
 #include <QApplication>
 
+#include "FeatureWorkerManager.h"
 #include "VeyonWorker.h"
 
 
@@ -39,8 +40,9 @@ int main( int argc, char **argv )
 		qFatal( "Not enough arguments (feature)" );
 	}
 
-	const auto featureUid = arguments[1];
-	if( QUuid( featureUid ).isNull() )
+	// pooled workers get their feature assigned by the server later
+	const auto featureUid = arguments[1] == FeatureWorkerManager::pooledWorkerArgument() ? QString() : arguments[1];
+	if( featureUid.isEmpty() == false && QUuid( featureUid ).isNull() )
 	{
 		qFatal( "Invalid feature UID given" );
 	}